@@ -0,0 +1,1427 @@
+﻿#include "App.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Fonts.h"
+#include "Importer.h"
+#include "Inventory.h"
+#include "Layout.h"
+#include "ListView.h"
+#include "OrderIndex.h"
+#include "Paragraph.h"
+#include "Perf.h"
+#include "Render.h"
+#include "Search.h"
+#include "TextBuffer.h"
+#include "Trace.h"
+#include "Undo.h"
+
+using namespace std;
+
+AppOptions ParseOptions(int argc, char* argv[]) {
+    AppOptions options;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--text-cache-mb" && i + 1 < argc) {
+            options.textCacheBytes = size_t(max(1L, strtol(argv[++i], nullptr, 10))) * 1024 * 1024;
+        }
+        else if (arg == "--text-workers" && i + 1 < argc) {
+            options.textWorkers = int(max(0L, strtol(argv[++i], nullptr, 10)));
+        }
+        else if (arg == "--catalog" && i + 1 < argc) {
+            options.catalogPath = argv[++i];
+        }
+        else if (arg == "--journal" && i + 1 < argc) {
+            options.journalPath = argv[++i];
+        }
+        else if (arg == "--fsync" && i + 1 < argc) {
+            string policy = argv[++i];
+            if (policy == "never") options.fsyncPolicy = FsyncPolicy::Never;
+            else if (policy == "interval") options.fsyncPolicy = FsyncPolicy::Interval;
+            else options.fsyncPolicy = FsyncPolicy::Commit;
+        }
+        else if (arg == "--group-commit-ms" && i + 1 < argc) {
+            options.groupCommitMs = Uint32(max(1L, strtol(argv[++i], nullptr, 10)));
+        }
+        else if (arg == "--journal-compact-kb" && i + 1 < argc) {
+            options.journalCompactBytes = Uint64(max(1L, strtol(argv[++i], nullptr, 10))) * 1024;
+        }
+        else if (arg == "--autosave-s" && i + 1 < argc) {
+            options.autosaveMs = Uint32(max(0L, strtol(argv[++i], nullptr, 10))) * 1000;
+        }
+        else if (arg == "--import" && i + 1 < argc) {
+            options.importPath = argv[++i];
+        }
+        else if (arg == "--continuous") {
+            options.continuousRendering = true;
+        }
+        else if (arg == "--font" && i + 1 < argc) {
+            options.fontPath = argv[++i];
+        }
+        else if (arg == "--headless") {
+            options.headless = true;
+        }
+        else if (arg == "--bench-toys" && i + 1 < argc) {
+            options.benchToys = int(max(0L, strtol(argv[++i], nullptr, 10)));
+        }
+        else if (arg == "--bench-frames" && i + 1 < argc) {
+            options.benchFrames = int(max(1L, strtol(argv[++i], nullptr, 10)));
+        }
+        else if (arg == "--trace" && i + 1 < argc) {
+            options.tracePath = argv[++i];
+            options.traceAtStart = true;
+        }
+        else {
+            cerr << "Unknown option: " << arg << endl;
+        }
+    }
+    if (options.journalPath.empty()) options.journalPath = options.catalogPath + ".journal";
+    if (options.headless) options.continuousRendering = true;
+    return options;
+}
+
+// Deterministic filler for benchmark runs; descriptions vary in length so
+// rows exercise both short and clipped text.
+void AddSyntheticToys(Inventory& inventory, int count) {
+    static const char* const words[] = {
+        "wooden", "plush", "remote", "puzzle", "racing", "glow", "magnetic", "musical",
+        "building", "classic", "deluxe", "mini", "giant", "electric", "soft", "retro"
+    };
+    const int wordCount = int(sizeof(words) / sizeof(words[0]));
+    Toy toy;
+    for (int i = 0; i < count; ++i) {
+        toy.name = string(words[i % wordCount]) + " toy #" + to_string(i + 1);
+        toy.description.clear();
+        for (int w = 0; w < 3 + i % 9; ++w) {
+            if (w > 0) toy.description.push_back(' ');
+            toy.description += words[(i * 7 + w * 3) % wordCount];
+        }
+        toy.price = Money::FromCents(99 + (i * 379) % 20000);
+        toy.quantity = i % 25;
+        inventory.Insert(inventory.NextId(), toy);
+    }
+}
+
+void PushClick(SDL_Rect rect) {
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = SDL_MOUSEBUTTONDOWN;
+    event.button.button = SDL_BUTTON_LEFT;
+    event.button.state = SDL_PRESSED;
+    event.button.clicks = 1;
+    event.button.x = rect.x + rect.w / 2;
+    event.button.y = rect.y + rect.h / 2;
+    SDL_PushEvent(&event);
+    event.type = SDL_MOUSEBUTTONUP;
+    event.button.state = SDL_RELEASED;
+    SDL_PushEvent(&event);
+}
+
+void PushKey(SDL_Keycode key) {
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = SDL_KEYDOWN;
+    event.key.state = SDL_PRESSED;
+    event.key.keysym.sym = key;
+    SDL_PushEvent(&event);
+}
+
+void PushText(const char* text) {
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = SDL_TEXTINPUT;
+    SDL_strlcpy(event.text.text, text, sizeof(event.text.text));
+    SDL_PushEvent(&event);
+}
+
+void PushWheel(int y) {
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = SDL_MOUSEWHEEL;
+    event.wheel.y = y;
+    event.wheel.direction = SDL_MOUSEWHEEL_NORMAL;
+    SDL_PushEvent(&event);
+}
+
+int RunApp(const AppOptions& options) {
+    if (options.headless) {
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    }
+
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        cerr << "SDL initialization error: " << SDL_GetError() << endl;
+        return 1;
+    }
+
+    if (TTF_Init() == -1) {
+        cerr << "SDL_ttf initialization error: " << TTF_GetError() << endl;
+        SDL_Quit();
+        return 1;
+    }
+
+    int winWidth = 800;
+    int winHeight = 600;
+
+    SDL_Window* window = SDL_CreateWindow("Toy Store",
+        SDL_WINDOWPOS_CENTERED,
+        SDL_WINDOWPOS_CENTERED,
+        winWidth, winHeight,
+        options.headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN | SDL_WINDOW_ALLOW_HIGHDPI | SDL_WINDOW_RESIZABLE);
+
+    if (!window) {
+        cerr << "Window creation error: " << SDL_GetError() << endl;
+        TTF_Quit();
+        SDL_Quit();
+        return 1;
+    }
+
+    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1,
+        options.headless ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    if (!renderer) {
+        cerr << "Renderer creation error: " << SDL_GetError() << endl;
+        SDL_DestroyWindow(window);
+        TTF_Quit();
+        SDL_Quit();
+        return 1;
+    }
+
+    FontManager fonts;
+    if (!fonts.Load(FontCandidates(options.fontPath))) {
+        cerr << "Font loading error: no usable font found" << endl;
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+        TTF_Quit();
+        SDL_Quit();
+        return 1;
+    }
+
+    // All sizes share one mapping of the font file. The smaller sizes are
+    // optional and fall back to the main font.
+    TTF_Font* font = fonts.Get(24);
+    TTF_Font* descFont = fonts.Get(18);
+    TTF_Font* hudFont = fonts.Get(14);
+    if (!descFont) descFont = font;
+    if (!hudFont) hudFont = font;
+
+    GlyphAtlas atlas(renderer);
+    atlas.MeasureText(font, prewarmGlyphs);
+    atlas.MeasureText(descFont, prewarmGlyphs);
+    TextCache textCache(renderer, options.textCacheBytes);
+    ParagraphCache paragraphs(atlas);
+
+    // 0 workers keeps rasterization on the render thread.
+    TextRasterizer textRasterizer;
+    textRasterizer.AddFont(font, fonts, 24);
+    if (options.textWorkers > 0 && textRasterizer.Start(options.textWorkers)) {
+        textCache.SetRasterizer(&textRasterizer);
+    }
+    ShapeBatch shapes;
+
+    auto FlushFrame = [&]() {
+        TraceZone zone("Flush");
+        shapes.Flush(renderer);
+        textCache.Flush();
+        atlas.Flush();
+        };
+
+    Inventory inventory;
+    Ledger ledger;
+
+    // Headless runs work on synthetic data and never touch the catalog,
+    // the journal or the importer.
+    Uint64 snapshotSeq = 0;
+    shared_ptr<Catalog> catalog = make_shared<Catalog>();
+    if (options.headless) {
+        AddSyntheticToys(inventory, options.benchToys);
+    }
+    else if (catalog->Open(options.catalogPath)) {
+        inventory.Load(catalog);
+        ledger.Load(*catalog);
+        snapshotSeq = catalog->JournalSeq();
+    }
+    else {
+        const Toy defaults[] = {
+            {"Lego Set", "A fun building set for kids.", { 2999 }, 10},
+            {"Doll", "A beautiful doll for imaginative play.", { 1999 }, 5},
+            {"Toy Car", "A speedy little car for racing.", { 999 }, 15}
+        };
+        for (const Toy& toy : defaults) {
+            inventory.Insert(inventory.NextId(), toy);
+        }
+    }
+    catalog.reset();
+
+    JournalReplayResult replay;
+    if (!options.headless) {
+        replay = ReplayJournal(options.journalPath, snapshotSeq, [&](const JournalEntry& entry) {
+            ApplyJournalEntry(inventory, ledger, entry);
+            });
+    }
+    if (replay.applied > 0) {
+        cout << "Recovered " << replay.applied << " journal entries" << endl;
+    }
+
+    Journal journal;
+    if (!options.headless) {
+        journal.Open(options.journalPath, options.catalogPath, replay.validBytes, replay.lastSeq,
+            options.fsyncPolicy, options.groupCommitMs, 1000);
+    }
+    if (replay.applied > 0) {
+        journal.RequestCompaction(inventory, ledger);
+    }
+
+    SearchIndex search;
+    InventoryOrder order;
+
+    // Applies, journals and indexes one entry.
+    auto Apply = [&](JournalEntry entry) {
+        if (entry.op == JournalOp::Add && entry.id == invalidToyId) {
+            entry.id = inventory.NextId();
+        }
+        // Every toy the entry touches, with the strings the search index
+        // holds for it.
+        struct Touched {
+            ToyId id;
+            int slot;
+            TextRef name;
+            TextRef description;
+        };
+        vector<Touched> touched;
+        auto Touch = [&](ToyId id) {
+            int slot = inventory.SlotOf(id);
+            touched.push_back({ id, slot, slot >= 0 ? inventory.Name(slot) : TextRef{ nullptr, 0 },
+                slot >= 0 ? inventory.Description(slot) : TextRef{ nullptr, 0 } });
+            };
+        if (entry.op == JournalOp::Checkout) {
+            for (const JournalLine& line : entry.lines) Touch(line.id);
+        }
+        else {
+            Touch(entry.id);
+        }
+        if (!ApplyJournalEntry(inventory, ledger, entry)) return false;
+        journal.Append(entry);
+
+        for (const Touched& old : touched) {
+            int newSlot = inventory.SlotOf(old.id);
+            TextRef newName = newSlot >= 0 ? inventory.Name(newSlot) : TextRef{ nullptr, 0 };
+            TextRef newDescription = newSlot >= 0 ? inventory.Description(newSlot) : TextRef{ nullptr, 0 };
+            if (newName.data != old.name.data || newDescription.data != old.description.data) {
+                if (old.slot >= 0) search.Remove(old.id, old.name, old.description);
+                if (newSlot >= 0) search.Add(old.id, newName, newDescription);
+            }
+            order.Update(inventory, old.id);
+        }
+        return true;
+        };
+
+    // User actions also record how to revert them; imports go straight to
+    // Apply and are not undoable.
+    UndoHistory history;
+    auto Commit = [&](JournalEntry entry) {
+        if (entry.op == JournalOp::Add && entry.id == invalidToyId) {
+            entry.id = inventory.NextId();
+        }
+        vector<JournalEntry> undo;
+        InvertJournalEntry(inventory, entry, undo);
+        if (!Apply(entry)) return false;
+        history.Record(undo, { entry });
+        return true;
+        };
+
+    CatalogImporter importer;
+    bool importRunning = false;
+    if (!options.importPath.empty() && !options.headless) {
+        importRunning = importer.Start(options.importPath);
+    }
+
+    AppState state = AppState::MENU;
+    bool running = true;
+    SDL_Event event;
+
+    // STORE rows are the search results while a query is typed, otherwise
+    // all toys in the sort order, or inventory slots when unsorted;
+    // storeSelectedIndex is a row.
+    int storeSelectedIndex = 0;
+    string storeQuery;
+    vector<ToyId> storeMatches;
+    Uint64 matchesRevision = ~0ULL;
+    SortColumn sortColumn = SortColumn::None;
+    bool sortDescending = false;
+
+    // Units to sell per toy; Ctrl and Shift clicks mark rows, and Sell
+    // checks the whole basket out as one entry. basketAnchor is where a
+    // Shift range starts.
+    unordered_map<ToyId, int> basket;
+    Uint64 basketVersion = 0;
+    ToyId basketAnchor = invalidToyId;
+
+    // Message shown at the right of the search box until storeNoticeUntil.
+    string storeNotice;
+    Uint32 storeNoticeUntil = 0;
+    auto ShowNotice = [&](const string& text) {
+        storeNotice = text;
+        storeNoticeUntil = SDL_GetTicks() + 4000;
+        };
+
+    auto RefreshSearch = [&]() {
+        if (!storeQuery.empty() && matchesRevision != inventory.Revision()) {
+            search.Query(storeQuery, inventory, storeMatches);
+            if (sortColumn != SortColumn::None) {
+                sort(storeMatches.begin(), storeMatches.end(), [&](ToyId a, ToyId b) {
+                    return sortDescending ? order.Less(sortColumn, b, a) : order.Less(sortColumn, a, b);
+                    });
+            }
+            matchesRevision = inventory.Revision();
+        }
+        };
+
+    auto StoreRows = [&]() {
+        RefreshSearch();
+        return storeQuery.empty() ? int(inventory.Size()) : int(storeMatches.size());
+        };
+
+    auto StoreSlot = [&](int row) {
+        if (!storeQuery.empty()) return inventory.SlotOf(storeMatches[row]);
+        if (sortColumn == SortColumn::None) return row;
+        int rank = sortDescending ? int(inventory.Size()) - 1 - row : row;
+        return inventory.SlotOf(order.At(sortColumn, size_t(rank)));
+        };
+
+    auto StoreRowOf = [&](ToyId id) {
+        if (!storeQuery.empty()) {
+            auto it = find(storeMatches.begin(), storeMatches.end(), id);
+            return it == storeMatches.end() ? -1 : int(it - storeMatches.begin());
+        }
+        if (sortColumn == SortColumn::None) return inventory.SlotOf(id);
+        int rank = order.Rank(sortColumn, id);
+        return rank < 0 || !sortDescending ? rank : int(inventory.Size()) - 1 - rank;
+        };
+
+    auto SelectedSlot = [&]() {
+        return storeSelectedIndex >= 0 && storeSelectedIndex < StoreRows() ? StoreSlot(storeSelectedIndex) : -1;
+        };
+
+    // Name, price and description. editScroll keeps each caret in view: in
+    // pixels for the one-line fields, as the first visible line for the
+    // wrapped description.
+    TextBuffer editFields[3];
+    int editScroll[3] = {};
+    int editFocusedField = 0;
+    const size_t editFieldLimit = 256;
+
+    auto InsertEditText = [&](const char* text) {
+        TextBuffer& field = editFields[editFocusedField];
+        string accepted;
+        for (const char* p = text; *p; ++p) {
+            if (editFocusedField == 1 && !(isdigit(static_cast<unsigned char>(*p)) || *p == '.' || *p == ',')) continue;
+            accepted.push_back(*p == '\n' || *p == '\r' || *p == '\t' ? ' ' : *p);
+        }
+        size_t kept = field.Size() - (field.SelectionEnd() - field.SelectionStart());
+        if (kept + accepted.size() < editFieldLimit) field.Insert(accepted.data(), accepted.size());
+        };
+
+    auto SaveEdit = [&]() {
+        int slot = SelectedSlot();
+        if (slot >= 0) {
+            JournalEntry entry;
+            entry.op = JournalOp::Edit;
+            entry.id = inventory.IdAt(slot);
+            entry.toy.name = editFields[0].Text();
+            entry.toy.description = editFields[2].Text();
+            if (!Money::Parse(editFields[1].Text(), entry.toy.price) || entry.toy.price.cents < 0) {
+                entry.toy.price = inventory.Price(slot);
+            }
+            TextRef name = inventory.Name(slot);
+            TextRef description = inventory.Description(slot);
+            bool unchanged = entry.toy.name.compare(0, string::npos, name.data, name.size) == 0 &&
+                entry.toy.description.compare(0, string::npos, description.data, description.size) == 0 &&
+                entry.toy.price == inventory.Price(slot);
+            // Saving without changes must not add journal records or undo steps.
+            if (unchanged) return;
+            Commit(entry);
+        }
+        };
+
+    SDL_Color bgMenuColor = { 30, 30, 60, 255 };
+    SDL_Color bgStoreColor = { 50, 50, 80, 255 };
+
+    SDL_Color baseTextColor = { 230, 230, 230, 255 };
+    SDL_Color highlightColorLight = { 255, 180, 180, 255 };
+    SDL_Color highlightColorDark = { 255, 120, 120, 255 };
+
+    Uint32 startTicks = SDL_GetTicks();
+
+    UiLayout layout;
+    layout.Update(winWidth, winHeight);
+    const MenuLayout& menuLayout = layout.menu;
+    const StoreLayout& storeLayout = layout.store;
+    const EditLayout& editLayout = layout.edit;
+
+    auto MeasureField = [&](TextBuffer& field) {
+        field.Measure([&](Uint32 prev, Uint32 cp) { return atlas.Advance(font, prev, cp); });
+        };
+
+    auto DescriptionLines = [&]() -> const vector<TextLine>& {
+        TextBuffer& field = editFields[2];
+        MeasureField(field);
+        const string& text = field.Text();
+        return paragraphs.Wrap(font, text.data(), text.size(), editLayout.descInput.w - 10);
+        };
+
+    // Puts the caret x pixels into a wrapped description line.
+    auto PlaceInLine = [&](const TextLine& line, int x, bool select) {
+        TextBuffer& field = editFields[2];
+        size_t offset = field.OffsetAtX(field.XAt(line.start) + x);
+        field.MoveTo(min(max(offset, size_t(line.start)), size_t(line.start + line.size)), select);
+        };
+
+    Uint64 stockRevision = ~0ULL;
+    Money stockValue = { 0 };
+    size_t outOfStock = 0;
+    Uint64 basketStatsRevision = ~0ULL;
+    Uint64 basketStatsVersion = ~0ULL;
+    Sint64 basketUnits = 0;
+    Money basketValue = { 0 };
+
+    ListView storeList;
+    bool draggingScrollbar = false;
+    int scrollbarGrabOffset = 0;
+
+    auto UpdateStoreList = [&]() {
+        layout.Apply(storeList, StoreRows());
+        };
+
+    auto SelectStoreItem = [&](int index) {
+        UpdateStoreList();
+        storeSelectedIndex = min(max(index, 0), max(0, StoreRows() - 1));
+        storeList.EnsureVisible(storeSelectedIndex);
+        };
+
+    // Ctrl+Z / Ctrl+Y on STORE; the affected toy becomes the selection.
+    auto UndoStep = [&](bool redo) {
+        vector<JournalEntry> entries;
+        if (!(redo ? history.Redo(entries) : history.Undo(entries))) return;
+        for (const JournalEntry& entry : entries) Apply(entry);
+        UpdateStoreList();
+        int row = entries.empty() ? -1 : StoreRowOf(entries.back().id);
+        SelectStoreItem(row >= 0 ? row : storeSelectedIndex);
+        };
+
+    // Each click on a header cycles ascending, descending, unsorted; the
+    // selected toy stays selected.
+    auto ToggleSort = [&](SortColumn column) {
+        int slot = SelectedSlot();
+        ToyId selected = slot >= 0 ? inventory.IdAt(slot) : invalidToyId;
+        if (sortColumn != column) {
+            sortColumn = column;
+            sortDescending = false;
+        }
+        else if (!sortDescending) {
+            sortDescending = true;
+        }
+        else {
+            sortColumn = SortColumn::None;
+        }
+        order.Require(inventory, sortColumn);
+        matchesRevision = ~0ULL;
+        int row = selected != invalidToyId ? StoreRowOf(selected) : -1;
+        SelectStoreItem(max(row, 0));
+        };
+
+    auto SetStoreQuery = [&](const string& query) {
+        storeQuery = query;
+        storeMatches.clear();
+        matchesRevision = ~0ULL;
+        storeList.scrollY = 0;
+        SelectStoreItem(0);
+        };
+
+    // In idle mode the scene is only redrawn after an event or when the
+    // selection pulse / cursor blink reaches its next step.
+    bool needsRedraw = true;
+    Uint32 redrawDeadline = 0;
+    Uint32 autosaveDeadline = 0;
+    Uint64 savedRevision = inventory.Revision();
+
+    auto NextRedrawDeadline = [&](Uint32 now) -> Uint32 {
+        if (importRunning) {
+            return now + 16;
+        }
+        if (state == AppState::STORE && SelectedSlot() >= 0) {
+            return now - (now - startTicks) % pulseStepMs + pulseStepMs;
+        }
+        if (state == AppState::STORE && !storeNotice.empty()) {
+            return SDL_TICKS_PASSED(now, storeNoticeUntil) ? now + 1 : storeNoticeUntil;
+        }
+        if (state == AppState::EDIT) {
+            return now - now % cursorBlinkMs + cursorBlinkMs;
+        }
+        return 0;
+        };
+
+    // The benchmark script replays a fixed tour of the UI through the normal
+    // event path: scroll and page through STORE, sell, edit a description,
+    // then return to MENU. Events are pushed against last frame's layout.
+    FrameStats frameStats;
+    int benchFrame = 0;
+
+    PerfHud hud;
+
+    auto PushScriptedEvents = [&](int frame) {
+        double progress = double(frame) / options.benchFrames;
+        if (frame == 1) {
+            PushClick(menuLayout.play);
+        }
+        else if (state == AppState::STORE && progress < 0.35) {
+            PushWheel(-1);
+        }
+        else if (state == AppState::STORE && progress < 0.5) {
+            PushKey(frame % 2 ? SDLK_PAGEDOWN : SDLK_DOWN);
+        }
+        else if (state == AppState::STORE && progress < 0.6) {
+            if (frame % 4 == 0) PushClick(storeLayout.sell);
+            else PushKey(SDLK_UP);
+        }
+        else if (state == AppState::STORE && progress < 0.62) {
+            PushClick(storeLayout.edit);
+            PushKey(SDLK_TAB);
+            PushKey(SDLK_TAB);
+        }
+        else if (state == AppState::EDIT && progress < 0.75) {
+            if (frame % 5 == 0) PushKey(SDLK_BACKSPACE);
+            else PushText(frame % 2 ? "a" : "b");
+        }
+        else if (state == AppState::EDIT) {
+            PushKey(SDLK_RETURN);
+        }
+        else if (state == AppState::STORE && progress < 0.95) {
+            PushKey(frame % 20 < 10 ? SDLK_END : SDLK_HOME);
+            PushWheel(frame % 3 == 0 ? 2 : -1);
+        }
+        else if (state == AppState::STORE) {
+            PushClick(storeLayout.back);
+        }
+        };
+
+    // F4 starts and stops a capture; stopping writes it to tracePath.
+    tracer.SetThreadName("main");
+    if (options.traceAtStart) tracer.Start();
+
+    SDL_StartTextInput();
+
+    while (running) {
+        if (options.headless) {
+            if (benchFrame == options.benchFrames) break;
+            PushScriptedEvents(benchFrame++);
+        }
+
+        if (!options.continuousRendering && !needsRedraw) {
+            Uint32 now = SDL_GetTicks();
+            Uint32 wakeAt = redrawDeadline;
+            if (autosaveDeadline != 0 && (wakeAt == 0 || SDL_TICKS_PASSED(wakeAt, autosaveDeadline))) {
+                wakeAt = autosaveDeadline;
+            }
+            if (wakeAt == 0) {
+                SDL_WaitEvent(nullptr);
+            }
+            else if (!SDL_TICKS_PASSED(now, wakeAt)) {
+                SDL_WaitEventTimeout(nullptr, int(wakeAt - now));
+            }
+            if (redrawDeadline != 0 && SDL_TICKS_PASSED(SDL_GetTicks(), redrawDeadline)) {
+                needsRedraw = true;
+            }
+        }
+
+        Uint64 frameStart = SDL_GetPerformanceCounter();
+        Uint64 allocationsAtStart = HeapAllocationCount();
+        renderCounters = RenderCounters();
+        TraceZone frameZone("Frame");
+        TraceZone eventsZone("Events");
+
+        while (SDL_PollEvent(&event)) {
+            needsRedraw = true;
+            if (event.type == SDL_QUIT) {
+                running = false;
+            }
+            else if (event.type == SDL_DROPFILE) {
+                if (importer.Start(event.drop.file)) {
+                    importRunning = true;
+                }
+                SDL_free(event.drop.file);
+            }
+            else if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_RESIZED) {
+                winWidth = event.window.data1;
+                winHeight = event.window.data2;
+                if (layout.Update(winWidth, winHeight)) {
+                    paragraphs.Clear();
+                }
+            }
+            else if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT) {
+                int mx = event.button.x;
+                int my = event.button.y;
+
+                if (state == AppState::MENU) {
+                    Widget hit = layout.menuGrid.HitTest(mx, my);
+                    if (hit == Widget::MenuPlay) {
+                        state = AppState::STORE;
+                        storeSelectedIndex = 0;
+                    }
+                    else if (hit == Widget::MenuExit) {
+                        running = false;
+                    }
+                }
+                else if (state == AppState::STORE) {
+                    UpdateStoreList();
+                    Widget hit = layout.storeGrid.HitTest(mx, my);
+                    if (hit == Widget::StoreUp) {
+                        if (storeSelectedIndex > 0) SelectStoreItem(storeSelectedIndex - 1);
+                    }
+                    else if (hit == Widget::StoreDown) {
+                        if (storeSelectedIndex < StoreRows() - 1) SelectStoreItem(storeSelectedIndex + 1);
+                    }
+                    else if (hit == Widget::StoreAdd) {
+                        JournalEntry entry;
+                        entry.op = JournalOp::Add;
+                        entry.toy = { "New Toy", "A newly added toy.", { 1499 }, 7 };
+                        entry.id = inventory.NextId();
+                        if (Commit(entry)) {
+                            UpdateStoreList();
+                            int row = StoreRowOf(entry.id);
+                            if (row >= 0) SelectStoreItem(row);
+                        }
+                    }
+                    else if (hit == Widget::StoreDelete) {
+                        int slot = SelectedSlot();
+                        if (slot >= 0) {
+                            JournalEntry entry;
+                            entry.op = JournalOp::Delete;
+                            entry.id = inventory.IdAt(slot);
+                            Commit(entry);
+                            if (storeSelectedIndex > 0) storeSelectedIndex--;
+                        }
+                    }
+                    else if (hit == Widget::StoreSell && !basket.empty()) {
+                        JournalEntry entry;
+                        entry.op = JournalOp::Checkout;
+                        entry.time = Sint64(time(nullptr));
+                        for (const auto& item : basket) {
+                            int slot = inventory.SlotOf(item.first);
+                            int units = slot >= 0 ? min(item.second, inventory.Quantity(slot)) : 0;
+                            if (units > 0) entry.lines.push_back({ item.first, units, inventory.Price(slot) * units });
+                        }
+                        sort(entry.lines.begin(), entry.lines.end(),
+                            [](const JournalLine& a, const JournalLine& b) { return a.id < b.id; });
+                        size_t skipped = basket.size() - entry.lines.size();
+                        if (entry.lines.empty()) {
+                            ShowNotice("Checkout: nothing in the basket is in stock");
+                        }
+                        else if (!Commit(entry)) {
+                            ShowNotice("Checkout failed: stock changed, the basket was kept");
+                        }
+                        else {
+                            basket.clear();
+                            basketVersion++;
+                            SelectStoreItem(storeSelectedIndex);
+                            if (skipped > 0) ShowNotice("Checkout: " + to_string(skipped) + " basket items were out of stock");
+                        }
+                    }
+                    else if (hit == Widget::StoreSell) {
+                        int slot = SelectedSlot();
+                        if (slot >= 0) {
+                            if (inventory.Quantity(slot) > 0) {
+                                JournalEntry entry;
+                                entry.op = JournalOp::Sell;
+                                entry.id = inventory.IdAt(slot);
+                                entry.amount = inventory.Price(slot);
+                                entry.time = Sint64(time(nullptr));
+                                Commit(entry);
+                                if (storeSelectedIndex >= StoreRows()) {
+                                    storeSelectedIndex = StoreRows() - 1;
+                                }
+                            }
+                        }
+                    }
+                    else if (hit == Widget::StoreEdit) {
+                        int slot = SelectedSlot();
+                        if (slot >= 0) {
+                            editFields[0].Assign(inventory.Name(slot).Str());
+                            editFields[1].Assign(inventory.Price(slot).ToString());
+                            editFields[2].Assign(inventory.Description(slot).Str());
+                            for (int& scroll : editScroll) scroll = 0;
+                            editFocusedField = 0;
+                            state = AppState::EDIT;
+                        }
+                    }
+                    else if (hit == Widget::StoreBack) {
+                        state = AppState::MENU;
+                    }
+                    else if (hit == Widget::StoreSearch) {
+                        // Typing in STORE always edits the query; the click hides a pending
+                        // notice so the query is visible and anchors the IME at the box.
+                        storeNotice.clear();
+                        SDL_SetTextInputRect(&storeLayout.search);
+                    }
+                    else if (hit == Widget::StoreSortName) {
+                        ToggleSort(SortColumn::Name);
+                    }
+                    else if (hit == Widget::StoreSortPrice) {
+                        ToggleSort(SortColumn::Price);
+                    }
+                    else if (hit == Widget::StoreSortQuantity) {
+                        ToggleSort(SortColumn::Quantity);
+                    }
+                    else if (hit == Widget::StoreScrollbar && storeList.MaxScroll() > 0) {
+                        SDL_Rect thumb = storeList.ScrollThumb();
+                        if (!IsPointInRect(mx, my, thumb)) {
+                            storeList.ScrollToThumb(my - thumb.h / 2);
+                            thumb = storeList.ScrollThumb();
+                        }
+                        draggingScrollbar = true;
+                        scrollbarGrabOffset = my - thumb.y;
+                    }
+                    else if (hit == Widget::StoreList) {
+                        int index = storeList.HitTest(mx, my);
+                        if (index >= 0) {
+                            SDL_Keymod mod = SDL_GetModState();
+                            ToyId id = inventory.IdAt(StoreSlot(index));
+                            if (mod & KMOD_SHIFT) {
+                                int anchor = basketAnchor != invalidToyId ? StoreRowOf(basketAnchor) : -1;
+                                if (anchor < 0) anchor = storeSelectedIndex;
+                                unordered_map<ToyId, int> range;
+                                for (int row = min(anchor, index); row <= max(anchor, index); ++row) {
+                                    ToyId rowId = inventory.IdAt(StoreSlot(row));
+                                    auto it = basket.find(rowId);
+                                    range[rowId] = it != basket.end() ? it->second : 1;
+                                }
+                                basket.swap(range);
+                            }
+                            else if (mod & KMOD_CTRL) {
+                                if (!basket.erase(id)) basket[id] = 1;
+                                basketAnchor = id;
+                            }
+                            else {
+                                basket.clear();
+                                basketAnchor = id;
+                            }
+                            basketVersion++;
+                            storeSelectedIndex = index;
+                        }
+                    }
+                }
+                else if (state == AppState::EDIT) {
+                    Widget hit = layout.editGrid.HitTest(mx, my);
+                    if (hit == Widget::EditName || hit == Widget::EditPrice || hit == Widget::EditDescription) {
+                        int index = hit == Widget::EditName ? 0 : hit == Widget::EditPrice ? 1 : 2;
+                        const SDL_Rect& rect = index == 0 ? editLayout.nameInput
+                            : index == 1 ? editLayout.priceInput : editLayout.descInput;
+                        bool extend = index == editFocusedField && (SDL_GetModState() & KMOD_SHIFT);
+                        editFocusedField = index;
+                        if (index == 2) {
+                            const vector<TextLine>& lines = DescriptionLines();
+                            int line = editScroll[2] + (my - rect.y - 5) / TTF_FontLineSkip(font);
+                            PlaceInLine(lines[min(max(line, 0), int(lines.size()) - 1)], mx - rect.x - 5, extend);
+                        }
+                        else {
+                            MeasureField(editFields[index]);
+                            editFields[index].MoveTo(editFields[index].OffsetAtX(mx - rect.x - 5 + editScroll[index]), extend);
+                        }
+                    }
+                    else if (hit == Widget::EditSave) {
+                        SaveEdit();
+                        state = AppState::STORE;
+                    }
+                    else if (hit == Widget::EditCancel) {
+                        state = AppState::STORE;
+                    }
+                }
+            }
+            else if (event.type == SDL_MOUSEBUTTONUP && event.button.button == SDL_BUTTON_LEFT) {
+                draggingScrollbar = false;
+            }
+            else if (event.type == SDL_MOUSEMOTION && draggingScrollbar && state == AppState::STORE) {
+                UpdateStoreList();
+                storeList.ScrollToThumb(event.motion.y - scrollbarGrabOffset);
+            }
+            else if (event.type == SDL_MOUSEWHEEL && state == AppState::STORE) {
+                int dy = event.wheel.direction == SDL_MOUSEWHEEL_FLIPPED ? -event.wheel.y : event.wheel.y;
+                UpdateStoreList();
+                storeList.ScrollBy(-dy * storeList.lineHeight);
+            }
+            else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F3) {
+                hud.Toggle();
+            }
+            else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F4) {
+                if (tracer.Enabled()) {
+                    tracer.Stop();
+                    tracer.Write(options.tracePath);
+                }
+                else {
+                    tracer.Start();
+                }
+            }
+            else if (event.type == SDL_KEYDOWN && state == AppState::STORE) {
+                UpdateStoreList();
+                switch (event.key.keysym.sym) {
+                case SDLK_UP:
+                    SelectStoreItem(storeSelectedIndex - 1);
+                    break;
+                case SDLK_DOWN:
+                    SelectStoreItem(storeSelectedIndex + 1);
+                    break;
+                case SDLK_PAGEUP:
+                    SelectStoreItem(storeSelectedIndex - storeList.PageRows());
+                    break;
+                case SDLK_PAGEDOWN:
+                    SelectStoreItem(storeSelectedIndex + storeList.PageRows());
+                    break;
+                case SDLK_HOME:
+                    SelectStoreItem(0);
+                    break;
+                case SDLK_END:
+                    SelectStoreItem(StoreRows() - 1);
+                    break;
+                case SDLK_BACKSPACE:
+                    if (!storeQuery.empty()) {
+                        string query = storeQuery;
+                        while (query.size() > 1 && (static_cast<unsigned char>(query.back()) & 0xC0) == 0x80) query.pop_back();
+                        query.pop_back();
+                        SetStoreQuery(query);
+                    }
+                    break;
+                case SDLK_ESCAPE:
+                    if (!storeQuery.empty()) SetStoreQuery(string());
+                    else if (!basket.empty()) {
+                        basket.clear();
+                        basketVersion++;
+                    }
+                    break;
+                case SDLK_EQUALS:
+                case SDLK_PLUS:
+                case SDLK_KP_PLUS:
+                case SDLK_MINUS:
+                case SDLK_KP_MINUS:
+                    // Ctrl +/- changes how many units of the current row go in the basket.
+                    if ((event.key.keysym.mod & KMOD_CTRL) && SelectedSlot() >= 0) {
+                        int slot = SelectedSlot();
+                        ToyId id = inventory.IdAt(slot);
+                        SDL_Keycode sym = event.key.keysym.sym;
+                        int units = basket.count(id) ? basket[id] : 0;
+                        units += sym == SDLK_MINUS || sym == SDLK_KP_MINUS ? -1 : 1;
+                        units = min(units, inventory.Quantity(slot));
+                        if (units > 0) basket[id] = units;
+                        else basket.erase(id);
+                        basketVersion++;
+                    }
+                    break;
+                case SDLK_z:
+                    if (event.key.keysym.mod & KMOD_CTRL) UndoStep((event.key.keysym.mod & KMOD_SHIFT) != 0);
+                    break;
+                case SDLK_y:
+                    if (event.key.keysym.mod & KMOD_CTRL) UndoStep(true);
+                    break;
+                default:
+                    break;
+                }
+            }
+            else if (event.type == SDL_TEXTINPUT && state == AppState::STORE) {
+                if (storeQuery.size() + strlen(event.text.text) < 64) {
+                    SetStoreQuery(storeQuery + event.text.text);
+                }
+            }
+            else if (event.type == SDL_TEXTINPUT && state == AppState::EDIT) {
+                InsertEditText(event.text.text);
+            }
+            else if (event.type == SDL_KEYDOWN && state == AppState::EDIT) {
+                TextBuffer& field = editFields[editFocusedField];
+                SDL_Keycode sym = event.key.keysym.sym;
+                bool shift = (event.key.keysym.mod & KMOD_SHIFT) != 0;
+                bool ctrl = (event.key.keysym.mod & KMOD_CTRL) != 0;
+
+                if (sym == SDLK_BACKSPACE) {
+                    field.Backspace();
+                }
+                else if (sym == SDLK_DELETE) {
+                    field.DeleteForward();
+                }
+                else if ((sym == SDLK_UP || sym == SDLK_DOWN) && editFocusedField == 2) {
+                    const vector<TextLine>& lines = DescriptionLines();
+                    size_t line = LineAt(lines, field.Cursor());
+                    int x = field.XAt(field.Cursor()) - field.XAt(lines[line].start);
+                    if (sym == SDLK_UP && line == 0) field.MoveTo(0, shift);
+                    else if (sym == SDLK_DOWN && line + 1 == lines.size()) field.MoveTo(field.Size(), shift);
+                    else PlaceInLine(lines[sym == SDLK_UP ? line - 1 : line + 1], x, shift);
+                }
+                else if (sym == SDLK_LEFT) {
+                    field.MoveLeft(shift, ctrl);
+                }
+                else if (sym == SDLK_RIGHT) {
+                    field.MoveRight(shift, ctrl);
+                }
+                else if (sym == SDLK_HOME) {
+                    field.MoveTo(0, shift);
+                }
+                else if (sym == SDLK_END) {
+                    field.MoveTo(field.Size(), shift);
+                }
+                else if (ctrl && sym == SDLK_a) {
+                    field.SelectAll();
+                }
+                else if (ctrl && sym == SDLK_z) {
+                    if (shift) field.Redo();
+                    else field.Undo();
+                }
+                else if (ctrl && sym == SDLK_y) {
+                    field.Redo();
+                }
+                else if (ctrl && (sym == SDLK_c || sym == SDLK_x) && field.HasSelection()) {
+                    SDL_SetClipboardText(field.Selected().c_str());
+                    if (sym == SDLK_x) field.Insert("", 0);
+                }
+                else if (ctrl && sym == SDLK_v && SDL_HasClipboardText()) {
+                    char* clipboard = SDL_GetClipboardText();
+                    if (clipboard) InsertEditText(clipboard);
+                    SDL_free(clipboard);
+                }
+                else if (event.key.keysym.sym == SDLK_TAB) {
+                    editFocusedField = (editFocusedField + 1) % 3;
+                }
+                else if (event.key.keysym.sym == SDLK_RETURN || event.key.keysym.sym == SDLK_KP_ENTER) {
+                    if (editFocusedField < 2) {
+                        editFocusedField++;
+                    }
+                    else {
+                        SaveEdit();
+                        state = AppState::STORE;
+                    }
+                }
+                else if (event.key.keysym.sym == SDLK_ESCAPE) {
+                    state = AppState::STORE;
+                }
+            }
+        }
+        eventsZone.End();
+
+        if (textCache.Collect()) {
+            needsRedraw = true;
+        }
+
+        if (importRunning) {
+            TraceZone zone("Import drain");
+            vector<Toy> importBatch;
+            for (int i = 0; i < 4 && importer.PollBatch(importBatch); ++i) {
+                for (Toy& toy : importBatch) {
+                    JournalEntry entry;
+                    entry.op = JournalOp::Add;
+                    entry.toy = move(toy);
+                    Apply(entry);
+                }
+            }
+            if (!importer.Active()) {
+                ImportStats importStats = importer.Stats();
+                cout << "Import finished: " << importStats.accepted << " added, "
+                    << importStats.rejected << " rejected" << endl;
+                importRunning = false;
+            }
+            needsRedraw = true;
+        }
+
+        // Copying the inventory only copies chunk pointers; the journal
+        // thread serializes the copy and renames it over the catalog.
+        if (inventory.Revision() != savedRevision && autosaveDeadline == 0 && options.autosaveMs > 0) {
+            autosaveDeadline = SDL_GetTicks() + options.autosaveMs;
+            if (autosaveDeadline == 0) autosaveDeadline = 1;
+        }
+        if (journal.BytesSinceCompaction() >= options.journalCompactBytes ||
+            (autosaveDeadline != 0 && SDL_TICKS_PASSED(SDL_GetTicks(), autosaveDeadline))) {
+            journal.RequestCompaction(inventory, ledger);
+            savedRevision = inventory.Revision();
+            autosaveDeadline = 0;
+            // The snapshot just handed to the journal keeps the old arena
+            // alive; the name order holds TextRefs into it and is rebuilt.
+            if (inventory.StringsNeedCompaction()) {
+                TraceZone zone("String compaction");
+                inventory.CompactStrings();
+                order = InventoryOrder();
+                order.Require(inventory, sortColumn);
+            }
+        }
+
+        UpdateStoreList();
+
+        if (!options.continuousRendering && !needsRedraw) {
+            continue;
+        }
+
+        Uint32 elapsed = SDL_GetTicks() - startTicks;
+        if (!options.continuousRendering) {
+            elapsed -= elapsed % pulseStepMs;
+        }
+        float t = (elapsed % pulsePeriodMs) / float(pulsePeriodMs);
+        float pulse = (sin(t * 2.f * 3.14159f) + 1.f) / 2.f;
+
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+        atlas.BeginFrame();
+
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderClear(renderer);
+
+        // One hover query per frame instead of one per button.
+        int mouseX, mouseY;
+        SDL_GetMouseState(&mouseX, &mouseY);
+        const WidgetGrid& grid = state == AppState::MENU ? layout.menuGrid
+            : state == AppState::STORE ? layout.storeGrid : layout.editGrid;
+        Widget hovered = grid.HitTest(mouseX, mouseY);
+
+        if (state == AppState::MENU) {
+            SDL_SetRenderDrawColor(renderer, bgMenuColor.r, bgMenuColor.g, bgMenuColor.b, bgMenuColor.a);
+            SDL_RenderClear(renderer);
+
+            auto DrawButton = [&](SDL_Rect rect, const string& label, Widget widget) {
+                SDL_Color baseColor = hovered == widget ? SDL_Color{ 255,180,180,220 } : SDL_Color{ 60,60,90,160 };
+                RenderRoundedRect(shapes, rect, baseColor, 12);
+                int w, h;
+                SDL_Texture* textTex = RenderText(textCache, font, label, baseTextColor, &w, &h);
+                if (textTex) {
+                    SDL_Rect textRect = { rect.x + (rect.w - w) / 2, rect.y + (rect.h - h) / 2, w, h };
+                    textCache.Draw(textTex, textRect);
+                }
+                };
+
+            DrawButton(menuLayout.play, "Play", Widget::MenuPlay);
+            DrawButton(menuLayout.exit, "Exit", Widget::MenuExit);
+
+            FlushFrame();
+        }
+        else if (state == AppState::STORE) {
+            SDL_SetRenderDrawColor(renderer, bgStoreColor.r, bgStoreColor.g, bgStoreColor.b, bgStoreColor.a);
+            SDL_RenderClear(renderer);
+
+            SDL_RenderSetClipRect(renderer, &storeList.viewport);
+
+            TraceZone rowsZone("STORE rows");
+            for (int i = storeList.FirstVisible(); i < storeList.EndVisible(); ++i) {
+                int slot = StoreSlot(i);
+                SDL_Color boxColor;
+                auto marked = basket.find(inventory.IdAt(slot));
+                if (i == storeSelectedIndex) {
+                    Uint8 r = Uint8(highlightColorDark.r * (1.f - pulse) + highlightColorLight.r * pulse);
+                    Uint8 g = Uint8(highlightColorDark.g * (1.f - pulse) + highlightColorLight.g * pulse);
+                    Uint8 b = Uint8(highlightColorDark.b * (1.f - pulse) + highlightColorLight.b * pulse);
+                    boxColor = { r, g, b, 200 };
+                }
+                else if (marked != basket.end()) {
+                    boxColor = { 90, 130, 120, 180 };
+                }
+                else {
+                    boxColor = { 80, 80, 120, 140 };
+                }
+
+                SDL_Rect boxRect = storeList.RowRect(i);
+                RenderRoundedRect(shapes, boxRect, boxColor, 10);
+
+                TextRef name = inventory.Name(slot);
+                TextRef description = inventory.Description(slot);
+                int priceX = boxRect.x + storeLayout.sortPrice.x - storeLayout.list.x + 15;
+                int quantityX = boxRect.x + storeLayout.sortQuantity.x - storeLayout.list.x + 15;
+                atlas.DrawText(font, name.data, name.size, baseTextColor, boxRect.x + 15, boxRect.y + 5, priceX - boxRect.x - 30);
+                atlas.DrawText(font, "$" + inventory.Price(slot).ToString(), baseTextColor, priceX, boxRect.y + 5);
+                string quantity = to_string(inventory.Quantity(slot));
+                if (marked != basket.end()) quantity = to_string(marked->second) + " of " + quantity;
+                atlas.DrawText(font, quantity, baseTextColor, quantityX, boxRect.y + 5);
+                int descY = boxRect.y + 5 + 26;
+                int descLines = (boxRect.y + boxRect.h - 5 - descY) / TTF_FontLineSkip(descFont);
+                if (descLines > 0) paragraphs.Draw(descFont, description.data, description.size, baseTextColor, boxRect.x + 15, descY, boxRect.w - 30, descLines);
+            }
+            rowsZone.End();
+
+            FlushFrame();
+            SDL_RenderSetClipRect(renderer, nullptr);
+
+            if (storeList.MaxScroll() > 0) {
+                RenderRoundedRect(shapes, storeList.ScrollTrack(), SDL_Color{ 30, 30, 50, 160 }, 5);
+                SDL_Color thumbColor = draggingScrollbar ? SDL_Color{ 255, 180, 180, 220 } : SDL_Color{ 120, 120, 170, 220 };
+                RenderRoundedRect(shapes, storeList.ScrollThumb(), thumbColor, 5);
+            }
+
+            auto DrawSortHeader = [&](SDL_Rect rect, const char* label, SortColumn column, Widget widget) {
+                SDL_Color color = hovered == widget ? SDL_Color{ 255, 180, 180, 200 } : SDL_Color{ 60, 60, 90, 160 };
+                RenderRoundedRect(shapes, rect, color, 6);
+                string text = label;
+                if (sortColumn == column) text += sortDescending ? " v" : " ^";
+                atlas.DrawText(font, text, baseTextColor, rect.x + 15, rect.y + (rect.h - TTF_FontHeight(font)) / 2, rect.w - 20);
+                };
+
+            DrawSortHeader(storeLayout.sortName, "Name", SortColumn::Name, Widget::StoreSortName);
+            DrawSortHeader(storeLayout.sortPrice, "Price", SortColumn::Price, Widget::StoreSortPrice);
+            DrawSortHeader(storeLayout.sortQuantity, "Quantity", SortColumn::Quantity, Widget::StoreSortQuantity);
+
+            SDL_Rect searchRect = storeLayout.search;
+            RenderRoundedRect(shapes, searchRect, SDL_Color{ 40, 40, 70, 200 }, 8);
+            int searchTextY = searchRect.y + (searchRect.h - TTF_FontHeight(font)) / 2;
+            if (!storeNotice.empty() && SDL_TICKS_PASSED(SDL_GetTicks(), storeNoticeUntil)) storeNotice.clear();
+            string searchStatus = !storeNotice.empty() ? storeNotice
+                : storeQuery.empty() ? string() : to_string(storeMatches.size()) + " found";
+            SDL_Color statusColor = !storeNotice.empty() ? SDL_Color{ 255, 160, 160, 255 } : SDL_Color{ 150, 150, 180, 255 };
+            int statusWidth = searchStatus.empty() ? 0 : atlas.MeasureText(font, searchStatus);
+            atlas.DrawText(font, searchStatus, statusColor, searchRect.x + searchRect.w - 10 - statusWidth, searchTextY);
+            if (storeQuery.empty()) {
+                atlas.DrawText(font, "Type to search", SDL_Color{ 150, 150, 180, 255 }, searchRect.x + 10, searchTextY,
+                    searchRect.w - 30 - statusWidth);
+            }
+            else {
+                atlas.DrawText(font, storeQuery, baseTextColor, searchRect.x + 10, searchTextY, searchRect.w - 30 - statusWidth);
+            }
+
+            if (stockRevision != inventory.Revision()) {
+                stockValue = inventory.TotalStockValue();
+                outOfStock = inventory.CountOutOfStock();
+                stockRevision = inventory.Revision();
+            }
+            if (basketStatsRevision != inventory.Revision() || basketStatsVersion != basketVersion) {
+                basketUnits = 0;
+                basketValue = Money::FromCents(0);
+                for (const auto& item : basket) {
+                    int slot = inventory.SlotOf(item.first);
+                    int units = slot >= 0 ? min(item.second, inventory.Quantity(slot)) : 0;
+                    if (units <= 0) continue;
+                    basketUnits += units;
+                    basketValue += inventory.Price(slot) * units;
+                }
+                basketStatsRevision = inventory.Revision();
+                basketStatsVersion = basketVersion;
+            }
+
+            stringstream balanceStream;
+            Sint64 now = Sint64(time(nullptr));
+            balanceStream << "Balance: $" << ledger.Total() << "   |   24h: $" << ledger.RangeSum(now - 24 * 3600, now + 1)
+                << "   |   Stock: $" << stockValue;
+            if (outOfStock > 0) balanceStream << " (" << outOfStock << " out of stock)";
+            if (!basket.empty()) balanceStream << "   |   Basket: " << basketUnits << " for $" << basketValue;
+            atlas.DrawText(font, balanceStream.str(), baseTextColor, 20, 20);
+
+            if (importRunning) {
+                ImportStats importStats = importer.Stats();
+                int percent = importStats.totalBytes ? int(importStats.bytesRead * 100 / importStats.totalBytes) : 0;
+                stringstream importStream;
+                importStream << "Importing " << percent << "%  (" << importStats.accepted << " added, "
+                    << importStats.rejected << " rejected)";
+                string importText = importStream.str();
+                atlas.DrawText(font, importText, baseTextColor, winWidth - 20 - atlas.MeasureText(font, importText), 20);
+            }
+
+            auto DrawButtonWithLabel = [&](SDL_Rect rect, const string& label, Widget widget) {
+                SDL_Color color = hovered == widget ? SDL_Color{ 255,180,180,220 } : SDL_Color{ 60,60,90,160 };
+                RenderRoundedRect(shapes, rect, color, 8);
+                int w, h;
+                SDL_Texture* textTex = RenderText(textCache, font, label, baseTextColor, &w, &h);
+                if (textTex) {
+                    SDL_Rect textRect = { rect.x + (rect.w - w) / 2, rect.y + (rect.h - h) / 2, w, h };
+                    textCache.Draw(textTex, textRect);
+                }
+                };
+
+            DrawButtonWithLabel(storeLayout.up, "Up", Widget::StoreUp);
+            DrawButtonWithLabel(storeLayout.down, "Down", Widget::StoreDown);
+            DrawButtonWithLabel(storeLayout.add, "Add", Widget::StoreAdd);
+            DrawButtonWithLabel(storeLayout.remove, "Delete", Widget::StoreDelete);
+            DrawButtonWithLabel(storeLayout.sell, "Sell", Widget::StoreSell);
+            DrawButtonWithLabel(storeLayout.edit, "Edit", Widget::StoreEdit);
+            DrawButtonWithLabel(storeLayout.back, "Menu", Widget::StoreBack);
+
+            FlushFrame();
+        }
+        else if (state == AppState::EDIT) {
+            SDL_SetRenderDrawColor(renderer, 40, 40, 70, 255);
+            SDL_RenderClear(renderer);
+
+            auto DrawLabel = [&](SDL_Rect rect, const string& text) {
+                int w, h;
+                SDL_Texture* tex = RenderText(textCache, font, text, baseTextColor, &w, &h);
+                if (tex) {
+                    SDL_Rect dst = { rect.x, rect.y, w, h };
+                    textCache.Draw(tex, dst);
+                }
+                };
+
+            DrawLabel(editLayout.nameLabel, "Toy Name");
+            DrawLabel(editLayout.priceLabel, "Price");
+            DrawLabel(editLayout.descLabel, "Description:");
+
+            auto DrawInputBox = [&](SDL_Rect rect, bool focused) {
+                SDL_Color bgColor = focused ? SDL_Color{ 60, 60, 90, 220 } : SDL_Color{ 40, 40, 70, 180 };
+                SDL_Color borderColor = focused ? SDL_Color{ 255, 180, 180, 255 } : SDL_Color{ 80, 80, 120, 255 };
+                RenderRoundedRect(shapes, rect, bgColor, 8);
+                SDL_Rect borderRect = { rect.x - 2, rect.y - 2, rect.w + 4, rect.h + 4 };
+                shapes.AddRectOutline(borderRect, borderColor);
+                };
+
+            DrawInputBox(editLayout.nameInput, editFocusedField == 0);
+            DrawInputBox(editLayout.priceInput, editFocusedField == 1);
+            DrawInputBox(editLayout.descInput, editFocusedField == 2);
+
+            auto RenderInputText = [&](SDL_Rect rect, int index) {
+                TextBuffer& field = editFields[index];
+                bool focused = index == editFocusedField;
+                MeasureField(field);
+
+                int h = TTF_FontHeight(font);
+                int x = rect.x + 5;
+                int y = rect.y + (rect.h - h) / 2;
+                int width = rect.w - 10;
+                int caretX = field.XAt(field.Cursor());
+                int& scroll = editScroll[index];
+                if (caretX - scroll > width - 2) scroll = caretX - width + 2;
+                if (caretX < scroll) scroll = caretX;
+
+                if (focused && field.HasSelection()) {
+                    int x0 = max(field.XAt(field.SelectionStart()) - scroll, 0);
+                    int x1 = min(field.XAt(field.SelectionEnd()) - scroll, width);
+                    shapes.AddRect({ x + x0, y, x1 - x0, h }, SDL_Color{ 120, 90, 140, 255 });
+                }
+
+                size_t first = field.OffsetAtX(scroll, true);
+                int firstX = field.XAt(first) - scroll;
+                atlas.DrawText(font, field.Text().data() + first, field.Size() - first, baseTextColor, x + firstX, y, width - firstX);
+
+                if (focused) {
+                    Uint32 ticks = SDL_GetTicks();
+                    DrawCursor(shapes, x + caretX - scroll + 1, y, h, ticks);
+                }
+                };
+
+            auto RenderDescription = [&](SDL_Rect rect) {
+                TextBuffer& field = editFields[2];
+                bool focused = editFocusedField == 2;
+                const vector<TextLine>& lines = DescriptionLines();
+                const char* data = field.Text().data();
+
+                int h = TTF_FontHeight(font);
+                int lineSkip = TTF_FontLineSkip(font);
+                int x = rect.x + 5;
+                int top = rect.y + 5;
+                int width = rect.w - 10;
+                int visible = max(1, (rect.h - 10) / lineSkip);
+                int caretLine = int(LineAt(lines, field.Cursor()));
+                int& firstLine = editScroll[2];
+                if (caretLine < firstLine) firstLine = caretLine;
+                if (caretLine >= firstLine + visible) firstLine = caretLine - visible + 1;
+                firstLine = min(firstLine, max(0, int(lines.size()) - visible));
+
+                int lastLine = min(int(lines.size()), firstLine + visible);
+                for (int i = firstLine; i < lastLine; ++i) {
+                    const TextLine& line = lines[i];
+                    int y = top + (i - firstLine) * lineSkip;
+                    int lineX = field.XAt(line.start);
+                    size_t start = max(field.SelectionStart(), size_t(line.start));
+                    size_t end = min(field.SelectionEnd(), size_t(line.start + line.size));
+                    if (focused && start < end) {
+                        int x0 = field.XAt(start) - lineX;
+                        int x1 = min(field.XAt(end) - lineX, width);
+                        shapes.AddRect({ x + x0, y, x1 - x0, h }, SDL_Color{ 120, 90, 140, 255 });
+                    }
+                    atlas.DrawText(font, data + line.start, line.size, baseTextColor, x, y, width);
+                }
+
+                if (focused) {
+                    Uint32 ticks = SDL_GetTicks();
+                    int caretX = min(field.XAt(field.Cursor()) - field.XAt(lines[caretLine].start), width - 1);
+                    DrawCursor(shapes, x + caretX + 1, top + (caretLine - firstLine) * lineSkip, h, ticks);
+                }
+                };
+
+            RenderInputText(editLayout.nameInput, 0);
+            RenderInputText(editLayout.priceInput, 1);
+            RenderDescription(editLayout.descInput);
+
+            auto DrawButton = [&](SDL_Rect rect, const string& label, Widget widget) {
+                SDL_Color color = hovered == widget ? SDL_Color{ 255,180,180,220 } : SDL_Color{ 60,60,90,180 };
+                RenderRoundedRect(shapes, rect, color, 12);
+                int w, h;
+                SDL_Texture* tex = RenderText(textCache, font, label, baseTextColor, &w, &h);
+                if (tex) {
+                    SDL_Rect dst = { rect.x + (rect.w - w) / 2, rect.y + (rect.h - h) / 2, w, h };
+                    textCache.Draw(tex, dst);
+                }
+                };
+
+            DrawButton(editLayout.save, "Save", Widget::EditSave);
+            DrawButton(editLayout.cancel, "Cancel", Widget::EditCancel);
+
+            FlushFrame();
+        }
+
+        if (hud.Visible()) {
+            TraceZone zone("HUD");
+            hud.Draw(shapes, atlas, hudFont, textCache.Stats(), winWidth);
+            FlushFrame();
+        }
+
+        {
+            TraceZone zone("Present");
+            SDL_RenderPresent(renderer);
+        }
+        frameZone.End();
+        if (tracer.Enabled()) tracer.Collect();
+
+        FrameSample frame;
+        frame.frameMs = (SDL_GetPerformanceCounter() - frameStart) * 1000.0 / double(SDL_GetPerformanceFrequency());
+        frame.counters = renderCounters;
+        frame.allocations = HeapAllocationCount() - allocationsAtStart;
+        hud.AddFrame(frame, frameStart);
+        if (options.headless) {
+            frameStats.Add(frame);
+        }
+
+        needsRedraw = false;
+        redrawDeadline = NextRedrawDeadline(SDL_GetTicks());
+    }
+
+    SDL_StopTextInput();
+
+    importer.Cancel();
+
+    if (journal.IsOpen()) {
+        journal.RequestCompaction(inventory, ledger);
+        journal.Close();
+    }
+    else if (!options.headless) {
+        WriteCatalog(options.catalogPath, inventory, ledger, replay.lastSeq);
+    }
+
+    if (tracer.Enabled()) {
+        tracer.Stop();
+        tracer.Write(options.tracePath);
+    }
+
+    if (options.headless) {
+        cout << "Headless benchmark: " << options.benchToys << " toys" << endl;
+        frameStats.Report(cout);
+    }
+
+    const TextCacheStats& cacheStats = textCache.Stats();
+    cout << "Text cache: " << cacheStats.hits << " hits, " << cacheStats.misses << " misses, "
+        << cacheStats.evictions << " evictions, " << cacheStats.entries << " entries, "
+        << cacheStats.bytes / 1024 << " KiB" << endl;
+
+    textRasterizer.Stop();
+    textCache.Release();
+    atlas.Release();
+    fonts.Close();
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    TTF_Quit();
+    SDL_Quit();
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <string>
+
+#include "Journal.h"
+
+enum class AppState {
+    MENU,
+    STORE,
+    EDIT,
+    EXIT
+};
+
+struct AppOptions {
+    size_t textCacheBytes = 16 * 1024 * 1024;
+    int textWorkers = 2;
+    bool continuousRendering = false;
+    std::string catalogPath = "toystore.cat";
+    std::string journalPath;
+    FsyncPolicy fsyncPolicy = FsyncPolicy::Commit;
+    Uint32 groupCommitMs = 5;
+    Uint64 journalCompactBytes = 4 * 1024 * 1024;
+    // Rewrite the catalog this long after the first unsaved change; 0 leaves
+    // it to journal compaction and exit.
+    Uint32 autosaveMs = 30000;
+    std::string importPath;
+    // Empty: the first usable font of FontCandidates().
+    std::string fontPath;
+    bool headless = false;
+    int benchToys = 10000;
+    int benchFrames = 600;
+    std::string tracePath = "toystore.trace.json";
+    bool traceAtStart = false;
+};
+
+AppOptions ParseOptions(int argc, char* argv[]);
+
+// Runs the UI until it is closed or, when headless, until the benchmark
+// script has played all frames.
+int RunApp(const AppOptions& options);
@@ -0,0 +1,99 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+const size_t cowChunkShift = 12;
+const size_t cowChunkSize = size_t(1) << cowChunkShift;
+
+// Vector split into fixed-size chunks behind shared pointers. A copy only
+// copies the chunk pointers, and a write into a chunk that another copy
+// still holds clones that chunk first. So a copy is an immutable version
+// that another thread may read while this one keeps changing.
+//
+// Copies may be read and destroyed on any thread, but only the thread that
+// owns the original may copy or write it.
+template <typename T>
+class CowVector {
+public:
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    const T& operator[](size_t index) const {
+        return (*chunks[index >> cowChunkShift])[index & (cowChunkSize - 1)];
+    }
+
+    T& Mutable(size_t index) {
+        return (*Own(index >> cowChunkShift))[index & (cowChunkSize - 1)];
+    }
+
+    void push_back(const T& value) {
+        if ((count & (cowChunkSize - 1)) == 0) {
+            chunks.push_back(std::make_shared<Chunk>());
+            chunks.back()->reserve(cowChunkSize);
+        }
+        Own(chunks.size() - 1)->push_back(value);
+        count++;
+    }
+
+    void pop_back() {
+        Chunk* last = Own(chunks.size() - 1);
+        last->pop_back();
+        if (last->empty()) chunks.pop_back();
+        count--;
+    }
+
+    void resize(size_t size, const T& value = T()) {
+        while (count > size) pop_back();
+        while (count < size) push_back(value);
+    }
+
+    void assign(size_t size, const T& value) {
+        chunks.clear();
+        count = 0;
+        resize(size, value);
+    }
+
+    // Chunks are contiguous, so scans can run over plain arrays.
+    size_t ChunkCount() const {
+        return chunks.size();
+    }
+
+    const T* ChunkData(size_t chunk) const {
+        return chunks[chunk]->data();
+    }
+
+    size_t ChunkSize(size_t chunk) const {
+        return chunks[chunk]->size();
+    }
+
+private:
+    typedef std::vector<T> Chunk;
+
+    Chunk* Own(size_t chunk) {
+        std::shared_ptr<Chunk>& slot = chunks[chunk];
+        if (slot.use_count() > 1) {
+            std::shared_ptr<Chunk> copy = std::make_shared<Chunk>();
+            copy->reserve(cowChunkSize);
+            copy->assign(slot->begin(), slot->end());
+            slot = std::move(copy);
+        }
+        else {
+            // Pairs with the release in the last reader's reference drop,
+            // so its reads happen before our writes.
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return slot.get();
+    }
+
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    size_t count = 0;
+};
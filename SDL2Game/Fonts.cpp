@@ -0,0 +1,77 @@
+﻿#include "Fonts.h"
+
+#include <iostream>
+
+using namespace std;
+
+const char* const prewarmGlyphs =
+    " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~";
+
+vector<string> FontCandidates(const string& preferred) {
+    vector<string> candidates;
+    if (!preferred.empty()) candidates.push_back(preferred);
+    const char* env = SDL_getenv("TOYSTORE_FONT");
+    if (env && *env) candidates.push_back(env);
+
+    // Visual Studio runs the exe from x64/<Config>/ with the project
+    // directory as the working directory, hence the parent paths.
+    const char* bundled = "fonts/Roboto.ttf";
+    char* basePath = SDL_GetBasePath();
+    if (basePath) {
+        string base = basePath;
+        SDL_free(basePath);
+        candidates.push_back(base + bundled);
+        candidates.push_back(base + "../" + bundled);
+        candidates.push_back(base + "../../" + bundled);
+    }
+    candidates.push_back(bundled);
+    candidates.push_back(string("../") + bundled);
+
+#ifdef _WIN32
+    candidates.push_back("C:\\Windows\\Fonts\\Bahnschrift.ttf");
+    candidates.push_back("C:\\Windows\\Fonts\\segoeui.ttf");
+#else
+    candidates.push_back("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+    candidates.push_back("/usr/share/fonts/TTF/DejaVuSans.ttf");
+#endif
+    return candidates;
+}
+
+bool FontManager::Load(const vector<string>& candidates) {
+    Close();
+    for (const string& candidate : candidates) {
+        if (!file.Open(candidate)) continue;
+        path = candidate;
+        TTF_Font* probe = Open(24);
+        if (probe) {
+            fonts.emplace_back(24, probe);
+            return true;
+        }
+        cerr << "Font loading error: " << candidate << ": " << TTF_GetError() << endl;
+        file.Close();
+    }
+    path.clear();
+    return false;
+}
+
+TTF_Font* FontManager::Get(int size) {
+    for (auto& font : fonts) {
+        if (font.first == size) return font.second;
+    }
+    TTF_Font* font = Open(size);
+    if (font) fonts.emplace_back(size, font);
+    return font;
+}
+
+TTF_Font* FontManager::Open(int size) const {
+    if (!file.Data()) return nullptr;
+    SDL_RWops* rw = SDL_RWFromConstMem(file.Data(), int(file.Size()));
+    if (!rw) return nullptr;
+    // SDL_ttf reads glyph data from rw lazily and closes it with the font.
+    return TTF_OpenFontRW(rw, 1, size);
+}
+
+void FontManager::Close() {
+    for (auto& font : fonts) TTF_CloseFont(font.second);
+    fonts.clear();
+}
@@ -0,0 +1,53 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Storage.h"
+
+// Glyphs rasterized into the atlas at startup, so the first frames do not
+// pay for them.
+extern const char* const prewarmGlyphs;
+
+// Font files to try, best first: preferred (from --font) when set, then
+// $TOYSTORE_FONT, the bundled fonts/Roboto.ttf next to the executable or
+// the working directory, and finally common system fonts.
+std::vector<std::string> FontCandidates(const std::string& preferred);
+
+// One font file mapped into memory once, with a shared handle per point
+// size opened over the mapping instead of re-reading the file.
+class FontManager {
+public:
+    FontManager() = default;
+
+    ~FontManager() {
+        Close();
+    }
+
+    FontManager(const FontManager&) = delete;
+    FontManager& operator=(const FontManager&) = delete;
+
+    // Keeps the first candidate that maps and opens as a font.
+    bool Load(const std::vector<std::string>& candidates);
+
+    const std::string& Path() const {
+        return path;
+    }
+
+    // Shared handle, opened on first use and closed by Close().
+    TTF_Font* Get(int size);
+
+    // A separate handle owned by the caller, e.g. for another thread.
+    TTF_Font* Open(int size) const;
+
+    // Closes the shared handles; must run before TTF_Quit.
+    void Close();
+
+private:
+    MappedFile file;
+    std::string path;
+    std::vector<std::pair<int, TTF_Font*>> fonts;
+};
@@ -0,0 +1,65 @@
+﻿#include <SDL.h>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+// Replacing the global allocation functions is the only way to see every
+// allocation, including the ones made inside the standard library. Only
+// executables link this file, so the tests keep the default allocator;
+// each thread counts its own calls, which keeps the UI figure free of the
+// text workers' and the journal writer's allocations.
+extern thread_local Uint64 heapAllocationsOnThread;
+
+void* operator new(size_t size) {
+    heapAllocationsOnThread++;
+    if (size == 0) size = 1;
+    while (true) {
+        void* p = malloc(size);
+        if (p) return p;
+        new_handler handler = get_new_handler();
+        if (!handler) throw bad_alloc();
+        handler();
+    }
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    try {
+        return operator new(size);
+    }
+    catch (const bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept {
+    return operator new(size, nothrow);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, const nothrow_t&) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, const nothrow_t&) noexcept {
+    free(p);
+}
@@ -0,0 +1,24 @@
+﻿#include "Importer.h"
+
+using namespace std;
+
+void TrimField(FieldView& field) {
+    while (field.size > 0 && isspace(static_cast<unsigned char>(field.data[0]))) {
+        field.data++;
+        field.size--;
+    }
+    while (field.size > 0 && isspace(static_cast<unsigned char>(field.data[field.size - 1]))) field.size--;
+}
+
+bool ParseCount(FieldView field, int& out) {
+    TrimField(field);
+    if (field.size == 0 || field.size > 9) return false;
+    int value = 0;
+    for (size_t i = 0; i < field.size; ++i) {
+        char c = field.data[i];
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + (c - '0');
+    }
+    out = value;
+    return true;
+}
@@ -0,0 +1,426 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Inventory.h"
+#include "Trace.h"
+#include "Utf8.h"
+
+// Non-owning slice of the importer's read buffer. Quoted/escaped fields are
+// unescaped in place, which never makes them longer.
+struct FieldView {
+    char* data = nullptr;
+    size_t size = 0;
+
+    bool Equals(const char* text) const {
+        size_t n = strlen(text);
+        if (n != size) return false;
+        for (size_t i = 0; i < n; ++i) {
+            if (tolower(static_cast<unsigned char>(data[i])) != text[i]) return false;
+        }
+        return true;
+    }
+};
+
+void TrimField(FieldView& field);
+bool ParseCount(FieldView field, int& out);
+
+enum ImportColumn {
+    ImportName,
+    ImportDescription,
+    ImportPrice,
+    ImportQuantity,
+    ImportColumnCount
+};
+
+enum class ImportFormat {
+    Csv,
+    JsonLines
+};
+
+struct ImportStats {
+    Uint64 totalBytes = 0;
+    Uint64 bytesRead = 0;
+    Uint64 accepted = 0;
+    Uint64 rejected = 0;
+    bool done = false;
+};
+
+// Streams a CSV or JSON Lines catalog in fixed-size chunks on a worker thread
+// and hands validated toys to the UI thread in batches through a bounded
+// queue, so memory stays flat regardless of the file size.
+class CatalogImporter {
+public:
+    ~CatalogImporter() {
+        Cancel();
+    }
+
+    bool Start(const std::string& path) {
+        if (Active()) {
+            std::cerr << "Import already running" << std::endl;
+            return false;
+        }
+        Cancel();
+        SDL_RWops* rw = SDL_RWFromFile(path.c_str(), "rb");
+        if (!rw) {
+            std::cerr << "Import open error: " << SDL_GetError() << std::endl;
+            return false;
+        }
+        ImportFormat format = ImportFormat::Csv;
+        size_t dot = path.find_last_of('.');
+        std::string ext = dot == std::string::npos ? std::string() : path.substr(dot);
+        for (char& c : ext) c = char(tolower(static_cast<unsigned char>(c)));
+        if (ext == ".jsonl" || ext == ".ndjson" || ext == ".json") format = ImportFormat::JsonLines;
+
+        stats = ImportStats();
+        Sint64 size = SDL_RWsize(rw);
+        stats.totalBytes = size > 0 ? Uint64(size) : 0;
+        cancelled = false;
+        worker = std::thread(&CatalogImporter::Run, this, rw, format);
+        return true;
+    }
+
+    bool PollBatch(std::vector<Toy>& out) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (batches.empty()) return false;
+        out.swap(batches.front());
+        batches.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    bool Active() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return worker.joinable() && (!stats.done || !batches.empty());
+    }
+
+    ImportStats Stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats;
+    }
+
+    void Cancel() {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cancelled = true;
+            batches.clear();
+        }
+        notFull.notify_all();
+        worker.join();
+    }
+
+private:
+    void Run(SDL_RWops* rw, ImportFormat format) {
+        tracer.SetThreadName("importer");
+        std::string buffer;
+        std::vector<Toy> batch;
+        batch.reserve(importBatchSize);
+        bool eof = false;
+        bool skipping = false;
+        bool firstRecord = true;
+        int columns[ImportColumnCount] = { 0, 1, 2, 3 };
+
+        while (!eof && !IsCancelled()) {
+            TraceZone zone("Import chunk");
+            size_t old = buffer.size();
+            buffer.resize(old + importChunkBytes);
+            size_t got = SDL_RWread(rw, &buffer[old], 1, importChunkBytes);
+            buffer.resize(old + got);
+            eof = got == 0;
+            AddBytesRead(got);
+
+            size_t pos = 0;
+            if (skipping) {
+                size_t newline = buffer.find('\n');
+                if (newline == std::string::npos) {
+                    buffer.clear();
+                    continue;
+                }
+                pos = newline + 1;
+                skipping = false;
+            }
+
+            while (pos < buffer.size()) {
+                size_t end = FindRecordEnd(buffer, pos, format);
+                if (end == std::string::npos) {
+                    if (!eof) break;
+                    end = buffer.size();
+                }
+                char* record = &buffer[pos];
+                size_t length = end - pos;
+                if (length > 0 && record[length - 1] == '\r') length--;
+                if (length > 0) {
+                    FieldView fields[ImportColumnCount];
+                    ParseResult result = format == ImportFormat::Csv
+                        ? ParseCsvRecord(record, length, fields, columns, firstRecord)
+                        : ParseJsonRecord(record, length, fields);
+                    firstRecord = false;
+                    Toy toy;
+                    if (result == ParseResult::Record && BuildToy(fields, toy)) {
+                        batch.push_back(std::move(toy));
+                        if (batch.size() >= importBatchSize) Emit(batch);
+                    }
+                    else if (result != ParseResult::Header) {
+                        CountRejected();
+                    }
+                }
+                pos = end + 1;
+            }
+
+            buffer.erase(0, std::min(pos, buffer.size()));
+            if (buffer.size() > importMaxRecordBytes) {
+                buffer.clear();
+                skipping = true;
+                CountRejected();
+            }
+        }
+
+        if (!batch.empty()) Emit(batch);
+        SDL_RWclose(rw);
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.done = true;
+    }
+
+    static size_t FindRecordEnd(const std::string& buffer, size_t pos, ImportFormat format) {
+        if (format == ImportFormat::JsonLines) return buffer.find('\n', pos);
+        bool quoted = false;
+        for (size_t i = pos; i < buffer.size(); ++i) {
+            if (buffer[i] == '"') quoted = !quoted;
+            else if (buffer[i] == '\n' && !quoted) return i;
+        }
+        return std::string::npos;
+    }
+
+    enum class ParseResult {
+        Record,
+        Header,
+        Invalid
+    };
+
+    // A first row starting with "name" is a header and remaps the column order.
+    static ParseResult ParseCsvRecord(char* p, size_t length, FieldView* out, int* columns, bool firstRecord) {
+        FieldView fields[8];
+        int count = 0;
+        size_t pos = 0;
+        while (count < 8) {
+            FieldView& field = fields[count++];
+            if (pos < length && p[pos] == '"') {
+                char* w = p + ++pos;
+                field.data = w;
+                while (pos < length) {
+                    if (p[pos] == '"') {
+                        if (pos + 1 < length && p[pos + 1] == '"') {
+                            *w++ = '"';
+                            pos += 2;
+                            continue;
+                        }
+                        pos++;
+                        break;
+                    }
+                    *w++ = p[pos++];
+                }
+                field.size = size_t(w - field.data);
+                while (pos < length && p[pos] != ',') pos++;
+            }
+            else {
+                size_t start = pos;
+                while (pos < length && p[pos] != ',') pos++;
+                field.data = p + start;
+                field.size = pos - start;
+                TrimField(field);
+            }
+            if (pos >= length) break;
+            pos++;
+        }
+
+        if (firstRecord && count > 0 && fields[0].Equals("name")) {
+            for (int c = 0; c < ImportColumnCount; ++c) columns[c] = -1;
+            for (int i = 0; i < count; ++i) {
+                if (fields[i].Equals("name")) columns[ImportName] = i;
+                else if (fields[i].Equals("description")) columns[ImportDescription] = i;
+                else if (fields[i].Equals("price")) columns[ImportPrice] = i;
+                else if (fields[i].Equals("quantity")) columns[ImportQuantity] = i;
+            }
+            return ParseResult::Header;
+        }
+
+        for (int c = 0; c < ImportColumnCount; ++c) {
+            if (columns[c] < 0 || columns[c] >= count) {
+                if (c == ImportDescription) continue;
+                return ParseResult::Invalid;
+            }
+            out[c] = fields[columns[c]];
+        }
+        return ParseResult::Record;
+    }
+
+    static bool ParseJsonString(char*& p, char* end, FieldView& out) {
+        if (p >= end || *p != '"') return false;
+        char* w = ++p;
+        out.data = w;
+        while (p < end && *p != '"') {
+            if (*p != '\\') {
+                *w++ = *p++;
+                continue;
+            }
+            if (++p >= end) return false;
+            char c = *p++;
+            switch (c) {
+            case 'n': *w++ = '\n'; break;
+            case 't': *w++ = '\t'; break;
+            case 'r': *w++ = '\r'; break;
+            case 'b': *w++ = '\b'; break;
+            case 'f': *w++ = '\f'; break;
+            case 'u': {
+                Uint32 cp = 0;
+                if (!ParseHex4(p, end, cp)) return false;
+                if (cp >= 0xD800 && cp <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                    char* q = p + 2;
+                    Uint32 low = 0;
+                    if (ParseHex4(q, end, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        p = q;
+                    }
+                }
+                w += EncodeUTF8(cp, w);
+                break;
+            }
+            default: *w++ = c; break;
+            }
+        }
+        if (p >= end) return false;
+        out.size = size_t(w - out.data);
+        ++p;
+        return true;
+    }
+
+    static bool ParseHex4(char*& p, char* end, Uint32& out) {
+        if (end - p < 4) return false;
+        out = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = *p++;
+            out <<= 4;
+            if (c >= '0' && c <= '9') out |= Uint32(c - '0');
+            else if (c >= 'a' && c <= 'f') out |= Uint32(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') out |= Uint32(c - 'A' + 10);
+            else return false;
+        }
+        return true;
+    }
+
+    static void SkipSpace(char*& p, char* end) {
+        while (p < end && isspace(static_cast<unsigned char>(*p))) ++p;
+    }
+
+    // Flat objects only: {"name": "...", "description": "...", "price": 1.5, "quantity": 3}.
+    static ParseResult ParseJsonRecord(char* p, size_t length, FieldView* out) {
+        char* end = p + length;
+        bool seen[ImportColumnCount] = {};
+        SkipSpace(p, end);
+        if (p >= end || *p++ != '{') return ParseResult::Invalid;
+        while (true) {
+            SkipSpace(p, end);
+            if (p < end && *p == '}') break;
+            FieldView key;
+            if (!ParseJsonString(p, end, key)) return ParseResult::Invalid;
+            SkipSpace(p, end);
+            if (p >= end || *p++ != ':') return ParseResult::Invalid;
+            SkipSpace(p, end);
+            FieldView value;
+            if (p < end && *p == '"') {
+                if (!ParseJsonString(p, end, value)) return ParseResult::Invalid;
+            }
+            else {
+                value.data = p;
+                while (p < end && *p != ',' && *p != '}' && !isspace(static_cast<unsigned char>(*p))) ++p;
+                value.size = size_t(p - value.data);
+                if (value.size == 0) return ParseResult::Invalid;
+            }
+            int column = key.Equals("name") ? ImportName
+                : key.Equals("description") ? ImportDescription
+                : key.Equals("price") ? ImportPrice
+                : key.Equals("quantity") ? ImportQuantity : -1;
+            if (column >= 0) {
+                out[column] = value;
+                seen[column] = true;
+            }
+            SkipSpace(p, end);
+            if (p < end && *p == ',') {
+                ++p;
+                continue;
+            }
+            if (p < end && *p == '}') break;
+            return ParseResult::Invalid;
+        }
+        bool complete = seen[ImportName] && seen[ImportPrice] && seen[ImportQuantity];
+        return complete ? ParseResult::Record : ParseResult::Invalid;
+    }
+
+    static bool BuildToy(const FieldView* fields, Toy& toy) {
+        FieldView name = fields[ImportName];
+        TrimField(name);
+        Money price;
+        int quantity;
+        if (name.size == 0 || !Money::Parse(fields[ImportPrice].data, fields[ImportPrice].size, price) ||
+            !ParseCount(fields[ImportQuantity], quantity)) {
+            return false;
+        }
+        if (price.cents < 0 || price.cents > maxImportPriceCents) return false;
+        toy.name.assign(name.data, name.size);
+        if (fields[ImportDescription].size > 0) {
+            toy.description.assign(fields[ImportDescription].data, fields[ImportDescription].size);
+        }
+        toy.price = price;
+        toy.quantity = quantity;
+        return true;
+    }
+
+    void Emit(std::vector<Toy>& batch) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull.wait(lock, [this] { return cancelled || batches.size() < importMaxQueuedBatches; });
+        if (!cancelled) {
+            stats.accepted += batch.size();
+            batches.push_back(std::move(batch));
+        }
+        batch = std::vector<Toy>();
+        batch.reserve(importBatchSize);
+    }
+
+    bool IsCancelled() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cancelled;
+    }
+
+    void AddBytesRead(size_t n) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.bytesRead += n;
+    }
+
+    void CountRejected() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.rejected++;
+    }
+
+    static const size_t importChunkBytes = 1 << 20;
+    static const size_t importMaxRecordBytes = 1 << 20;
+    static const size_t importBatchSize = 1024;
+    static const size_t importMaxQueuedBatches = 8;
+    static const Sint64 maxImportPriceCents = 100000000000LL;
+
+    std::thread worker;
+    std::mutex mutex_;
+    std::condition_variable notFull;
+    std::deque<std::vector<Toy>> batches;
+    ImportStats stats;
+    bool cancelled = false;
+};
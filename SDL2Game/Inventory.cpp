@@ -0,0 +1,73 @@
+﻿#include "Inventory.h"
+
+using namespace std;
+
+ostream& operator<<(ostream& out, Money money) {
+    return out << money.ToString();
+}
+
+bool WriteCatalog(const string& path, const Inventory& inventory, const Ledger& ledger, Uint64 journalSeq) {
+    // Records and heap offsets are Uint32 in the catalog format; refuse to write a
+    // catalog that does not fit instead of truncating them.
+    const Uint64 fieldLimit = numeric_limits<Uint32>::max();
+    if (inventory.Size() > fieldLimit) {
+        cerr << "Catalog write error: too many toys for the catalog format" << endl;
+        return false;
+    }
+    vector<CatalogRecord> records;
+    records.reserve(inventory.Size());
+    string heap;
+    for (size_t i = 0; i < inventory.Size(); ++i) {
+        TextRef name = inventory.Name(i);
+        TextRef description = inventory.Description(i);
+        if (Uint64(heap.size()) + name.size + 1 + description.size > fieldLimit) {
+            cerr << "Catalog write error: text heap exceeds the catalog format limit" << endl;
+            return false;
+        }
+        CatalogRecord record = CatalogRecord();
+        record.id = inventory.IdAt(i);
+        record.nameOffset = Uint32(heap.size());
+        record.nameLength = name.size;
+        heap.append(name.data, name.size).push_back('\0');
+        record.descriptionOffset = Uint32(heap.size());
+        record.descriptionLength = description.size;
+        heap.append(description.data, description.size).push_back('\0');
+        record.priceCents = inventory.Price(i).cents;
+        record.quantity = inventory.Quantity(i);
+        records.push_back(record);
+    }
+
+    CatalogHeader header = CatalogHeader();
+    memcpy(header.magic, catalogMagic, sizeof(catalogMagic));
+    header.version = catalogVersion;
+    header.recordCount = Uint32(records.size());
+    header.recordsOffset = sizeof(CatalogHeader);
+    header.heapOffset = header.recordsOffset + records.size() * sizeof(CatalogRecord);
+    header.heapSize = heap.size();
+    header.balanceCents = ledger.Total().cents;
+    header.journalSeq = journalSeq;
+    header.ledgerOffset = header.heapOffset + heap.size();
+    header.ledgerCount = ledger.Size();
+
+    string tmpPath = path + ".tmp";
+    RawFile out;
+    if (!out.Open(tmpPath, true)) {
+        cerr << "Catalog write error: cannot create " << tmpPath << endl;
+        return false;
+    }
+    bool ok = out.Write(&header, sizeof(header));
+    if (ok && !records.empty()) ok = out.Write(records.data(), records.size() * sizeof(CatalogRecord));
+    if (ok && !heap.empty()) ok = out.Write(heap.data(), heap.size());
+    const CowVector<LedgerRecord>& sales = ledger.Records();
+    for (size_t c = 0; ok && c < sales.ChunkCount(); ++c) {
+        ok = out.Write(sales.ChunkData(c), sales.ChunkSize(c) * sizeof(LedgerRecord));
+    }
+    if (ok) ok = out.Sync();
+    out.Close();
+    if (!ok || !ReplaceFileAtomic(tmpPath, path)) {
+        cerr << "Catalog write error: could not replace " << path << endl;
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
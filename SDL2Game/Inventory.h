@@ -0,0 +1,612 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CowVector.h"
+#include "Storage.h"
+
+// Fixed-point currency in whole cents, so sums and comparisons are exact.
+struct Money {
+    Sint64 cents;
+
+    static Money FromCents(Sint64 cents) {
+        return { cents };
+    }
+
+    // Accepts "12", "12.5", "$12.34", "-3" and a comma as the decimal
+    // separator. A third fractional digit rounds half away from zero and
+    // any further digits are ignored.
+    static bool Parse(const char* text, size_t size, Money& out) {
+        const char* p = text;
+        const char* end = text + size;
+        while (p < end && isspace(static_cast<unsigned char>(*p))) ++p;
+        while (end > p && isspace(static_cast<unsigned char>(end[-1]))) --end;
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+        if (p < end && *p == '$') ++p;
+
+        Sint64 whole = 0;
+        int digits = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+            if (++digits > 15) return false;
+            whole = whole * 10 + (*p - '0');
+        }
+        Sint64 fraction = 0;
+        int fractionDigits = 0;
+        if (p < end && (*p == '.' || *p == ',')) {
+            for (++p; p < end && *p >= '0' && *p <= '9'; ++p, ++fractionDigits) {
+                if (fractionDigits < 2) fraction = fraction * 10 + (*p - '0');
+                else if (fractionDigits == 2 && *p >= '5') fraction++;
+            }
+        }
+        if (p != end || digits + fractionDigits == 0) return false;
+        if (fractionDigits == 1) fraction *= 10;
+        Sint64 cents = whole * 100 + fraction;
+        out.cents = negative ? -cents : cents;
+        return true;
+    }
+
+    static bool Parse(const std::string& text, Money& out) {
+        return Parse(text.data(), text.size(), out);
+    }
+
+    std::string ToString() const {
+        Uint64 magnitude = cents < 0 ? Uint64(0) - Uint64(cents) : Uint64(cents);
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%s%llu.%02u", cents < 0 ? "-" : "",
+            static_cast<unsigned long long>(magnitude / 100), unsigned(magnitude % 100));
+        return buffer;
+    }
+
+    Money& operator+=(Money other) {
+        cents += other.cents;
+        return *this;
+    }
+
+    Money& operator-=(Money other) {
+        cents -= other.cents;
+        return *this;
+    }
+
+    Money operator+(Money other) const {
+        return { cents + other.cents };
+    }
+
+    Money operator-(Money other) const {
+        return { cents - other.cents };
+    }
+
+    Money operator*(Sint64 count) const {
+        return { cents * count };
+    }
+
+    bool operator==(Money other) const {
+        return cents == other.cents;
+    }
+
+    bool operator!=(Money other) const {
+        return cents != other.cents;
+    }
+
+    bool operator<(Money other) const {
+        return cents < other.cents;
+    }
+};
+
+std::ostream& operator<<(std::ostream& out, Money money);
+
+struct Toy {
+    std::string name;
+    std::string description;
+    Money price;
+    int quantity;
+};
+
+// On-disk catalog: a fixed header, a fixed-stride record table and a heap of
+// NUL-terminated UTF-8 strings. All fields are little-endian.
+const char catalogMagic[8] = { 'T', 'O', 'Y', 'C', 'A', 'T', '\0', '\0' };
+const Uint32 catalogVersion = 4;
+
+struct CatalogHeader {
+    char magic[8];
+    Uint32 version;
+    Uint32 recordCount;
+    Uint64 recordsOffset;
+    Uint64 heapOffset;
+    Uint64 heapSize;
+    Sint64 balanceCents;
+    Uint64 journalSeq;
+    Uint64 ledgerOffset;
+    Uint64 ledgerCount;
+};
+
+struct CatalogRecord {
+    Uint32 id;
+    Uint32 nameOffset;
+    Uint32 nameLength;
+    Uint32 descriptionOffset;
+    Uint32 descriptionLength;
+    Sint32 quantity;
+    Sint64 priceCents;
+};
+
+typedef Uint32 ToyId;
+const ToyId invalidToyId = 0;
+
+// One sale, both in memory and in the catalog's ledger section.
+struct LedgerRecord {
+    Sint64 time;
+    Sint64 amountCents;
+    ToyId id;
+    Sint32 quantity;
+};
+
+// Ids index a dense slot table on load, so a catalog may not hold ids
+// far beyond its record count; the floor leaves room for deleted toys.
+const Uint32 catalogIdFactor = 4;
+const Uint32 catalogIdFloor = 1 << 20;
+
+static_assert(sizeof(CatalogHeader) == 72, "CatalogHeader layout changed");
+static_assert(sizeof(CatalogRecord) == 32, "CatalogRecord layout changed");
+static_assert(sizeof(LedgerRecord) == 24, "LedgerRecord layout changed");
+
+// Opening validates the header and the toy ids; records are decoded on
+// demand.
+class Catalog {
+public:
+    bool Open(const std::string& path) {
+        if (!file.Open(path)) return false;
+        if (file.Size() < sizeof(header)) return Fail(path, "file is truncated");
+        memcpy(&header, file.Data(), sizeof(header));
+        if (memcmp(header.magic, catalogMagic, sizeof(catalogMagic)) != 0) return Fail(path, "bad magic");
+        if (header.version != catalogVersion) return Fail(path, "unsupported version");
+        Uint64 recordsEnd = header.recordsOffset + Uint64(header.recordCount) * sizeof(CatalogRecord);
+        Uint64 ledgerEnd = header.ledgerOffset + header.ledgerCount * sizeof(LedgerRecord);
+        if (recordsEnd > file.Size() || header.heapOffset + header.heapSize > file.Size() ||
+            header.ledgerCount > file.Size() / sizeof(LedgerRecord) || ledgerEnd > file.Size()) {
+            return Fail(path, "sections out of bounds");
+        }
+        Uint64 maxId = std::min<Uint64>(std::max<Uint64>(Uint64(header.recordCount) * catalogIdFactor, catalogIdFloor),
+            std::numeric_limits<Uint32>::max() - 1);
+        std::vector<bool> seen(size_t(maxId) + 1);
+        for (size_t i = 0; i < header.recordCount; ++i) {
+            ToyId id = Record(i).id;
+            if (id == invalidToyId || id > maxId || seen[id]) return Fail(path, "bad or repeated toy id");
+            seen[id] = true;
+        }
+        return true;
+    }
+
+    void Close() {
+        file.Close();
+        header = CatalogHeader();
+    }
+
+    size_t Size() const {
+        return header.recordCount;
+    }
+
+    Money Balance() const {
+        return Money::FromCents(header.balanceCents);
+    }
+
+    Uint64 JournalSeq() const {
+        return header.journalSeq;
+    }
+
+    CatalogRecord Record(size_t index) const {
+        CatalogRecord record;
+        memcpy(&record, file.Data() + header.recordsOffset + index * sizeof(CatalogRecord), sizeof(record));
+        return record;
+    }
+
+    size_t LedgerSize() const {
+        return size_t(header.ledgerCount);
+    }
+
+    LedgerRecord LedgerAt(size_t index) const {
+        LedgerRecord record;
+        memcpy(&record, file.Data() + header.ledgerOffset + index * sizeof(LedgerRecord), sizeof(record));
+        return record;
+    }
+
+    // Points into the mapping, which stays valid until Close().
+    const char* HeapString(Uint32 offset, Uint32& length) const {
+        if (Uint64(offset) + length >= header.heapSize) {
+            length = 0;
+            return "";
+        }
+        return reinterpret_cast<const char*>(file.Data() + header.heapOffset + offset);
+    }
+
+    bool OwnsText(const char* text) const {
+        const char* heap = reinterpret_cast<const char*>(file.Data() + header.heapOffset);
+        return text >= heap && text < heap + header.heapSize;
+    }
+
+private:
+    bool Fail(const std::string& path, const char* reason) {
+        std::cerr << "Catalog " << path << ": " << reason << std::endl;
+        Close();
+        return false;
+    }
+
+    MappedFile file;
+    CatalogHeader header = CatalogHeader();
+};
+
+const Sint64 ledgerBucketSeconds = 3600;
+
+// Hourly buckets kept for range sums, about two years. Sales outside the
+// window are counted in its oldest bucket, so a corrupt or far-off sale time
+// costs a wrong range sum instead of an unbounded allocation.
+const Sint64 ledgerMaxBuckets = 24 * 366 * 2;
+
+// Append-only sales ledger on top of an opening balance. The total is kept
+// incrementally, and a Fenwick tree over hourly buckets answers range sums in
+// O(log buckets); ranges are widened to whole buckets. Records are chunked
+// copy-on-write, so copying a long ledger stays cheap.
+class Ledger {
+public:
+    // The catalog stores the total balance, so the opening balance is
+    // whatever the recorded sales do not account for.
+    void Load(const Catalog& source) {
+        *this = Ledger();
+        size_t n = source.LedgerSize();
+        for (size_t i = 0; i < n; ++i) {
+            Record(source.LedgerAt(i));
+        }
+        opening = source.Balance() - sales;
+    }
+
+    void Record(const LedgerRecord& record) {
+        records.push_back(record);
+        sales.cents += record.amountCents;
+        AddToBucket(record.time, record.amountCents);
+    }
+
+    Money Total() const {
+        return opening + sales;
+    }
+
+    size_t Size() const {
+        return records.size();
+    }
+
+    const LedgerRecord& At(size_t index) const {
+        return records[index];
+    }
+
+    const CowVector<LedgerRecord>& Records() const {
+        return records;
+    }
+
+    // Sales in every bucket overlapping [from, to).
+    Money RangeSum(Sint64 from, Sint64 to) const {
+        if (to <= from) return Money::FromCents(0);
+        return Money::FromCents(Prefix(BucketOf(to - 1) + 1) - Prefix(BucketOf(from)));
+    }
+
+private:
+    static Sint64 BucketOf(Sint64 time) {
+        Sint64 bucket = time / ledgerBucketSeconds;
+        return time % ledgerBucketSeconds < 0 ? bucket - 1 : bucket;
+    }
+
+    // Sum of every bucket before the given one.
+    Sint64 Prefix(Sint64 bucket) const {
+        if (buckets.empty() || bucket <= origin) return 0;
+        size_t i = size_t(std::min(bucket - origin, Sint64(buckets.size())));
+        Sint64 sum = 0;
+        for (; i > 0; i -= i & (0 - i)) sum += tree[i];
+        return sum;
+    }
+
+    void AddToBucket(Sint64 time, Sint64 cents) {
+        Sint64 bucket = BucketOf(time);
+        if (buckets.empty()) origin = bucket;
+        if (bucket - origin >= ledgerMaxBuckets) {
+            // Slide the window so the new bucket lands three quarters in;
+            // sales in time order then slide it once per quarter window.
+            // Buckets that drop out fold into the new oldest one.
+            Sint64 newOrigin = bucket - ledgerMaxBuckets * 3 / 4;
+            size_t dropped = size_t(std::min(newOrigin - origin, Sint64(buckets.size())));
+            Sint64 folded = 0;
+            for (size_t i = 0; i < dropped; ++i) folded += buckets[i];
+            buckets.erase(buckets.begin(), buckets.begin() + dropped);
+            if (buckets.empty()) buckets.push_back(0);
+            buckets[0] += folded;
+            origin = newOrigin;
+            Rebuild(tree.size() - 1);
+        }
+        if (bucket < origin) bucket = std::max(bucket, origin + Sint64(buckets.size()) - ledgerMaxBuckets);
+        if (bucket < origin) {
+            buckets.insert(buckets.begin(), size_t(origin - bucket), 0);
+            origin = bucket;
+            Rebuild(std::max(buckets.size(), tree.size() - 1));
+        }
+        size_t index = size_t(bucket - origin);
+        if (index >= buckets.size()) buckets.resize(index + 1, 0);
+        if (index + 1 >= tree.size()) Rebuild(std::min(std::max(index + 1, 2 * tree.size()), size_t(ledgerMaxBuckets)));
+        buckets[index] += cents;
+        for (size_t i = index + 1; i < tree.size(); i += i & (0 - i)) tree[i] += cents;
+    }
+
+    void Rebuild(size_t capacity) {
+        tree.assign(capacity + 1, 0);
+        for (size_t i = 1; i <= capacity; ++i) {
+            if (i <= buckets.size()) tree[i] += buckets[i - 1];
+            size_t parent = i + (i & (0 - i));
+            if (parent <= capacity) tree[parent] += tree[i];
+        }
+    }
+
+    CowVector<LedgerRecord> records;
+    Money opening = { 0 };
+    Money sales = { 0 };
+    Sint64 origin = 0;
+    std::vector<Sint64> buckets;
+    std::vector<Sint64> tree;
+};
+
+// Immutable NUL-terminated string living either in the mapped catalog heap
+// or in a StringArena chunk; neither moves or is freed while referenced.
+struct TextRef {
+    const char* data;
+    Uint32 size;
+
+    std::string Str() const {
+        return std::string(data, size);
+    }
+};
+
+const size_t stringArenaChunkBytes = 256 * 1024;
+
+// Dead arena bytes at which Inventory::StringsNeedCompaction starts to
+// report true, as long as they are also half of the arena.
+const size_t stringArenaCompactBytes = 4 * stringArenaChunkBytes;
+
+class StringArena {
+public:
+    TextRef Add(const char* text, size_t size) {
+        if (size + 1 > remaining) {
+            size_t capacity = std::max(stringArenaChunkBytes, size + 1);
+            chunks.emplace_back(new char[capacity]);
+            cursor = chunks.back().get();
+            remaining = capacity;
+        }
+        char* out = cursor;
+        memcpy(out, text, size);
+        out[size] = '\0';
+        cursor += size + 1;
+        remaining -= size + 1;
+        bytes += size + 1;
+        return { out, Uint32(size) };
+    }
+
+    size_t Bytes() const {
+        return bytes;
+    }
+
+private:
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char* cursor = nullptr;
+    size_t remaining = 0;
+    size_t bytes = 0;
+};
+
+const Uint32 invalidSlot = 0xFFFFFFFF;
+
+// Structure-of-arrays inventory. Each toy has a stable id; slots are dense
+// and removal swaps the last slot into the hole, so order is not preserved.
+// Columns are copy-on-write and copies share the string storage, so a copy
+// is an O(chunks) snapshot that a background writer can serialize while the
+// original keeps changing.
+class Inventory {
+public:
+    Inventory() : arena(std::make_shared<StringArena>()) {
+    }
+
+    size_t Size() const {
+        return ids.size();
+    }
+
+    bool Empty() const {
+        return ids.empty();
+    }
+
+    Uint64 Revision() const {
+        return revision;
+    }
+
+    ToyId NextId() const {
+        return nextId;
+    }
+
+    void Load(const std::shared_ptr<Catalog>& source) {
+        *this = Inventory();
+        catalog = source;
+        size_t n = source->Size();
+        for (size_t i = 0; i < n; ++i) {
+            CatalogRecord record = source->Record(i);
+            ids.push_back(record.id);
+            prices.push_back(record.priceCents);
+            quantities.push_back(record.quantity);
+            names.push_back({ source->HeapString(record.nameOffset, record.nameLength), record.nameLength });
+            descriptions.push_back({ source->HeapString(record.descriptionOffset, record.descriptionLength), record.descriptionLength });
+            nextId = std::max(nextId, record.id + 1);
+        }
+        slotOfId.assign(nextId, invalidSlot);
+        for (size_t i = 0; i < n; ++i) {
+            if (ids[i] != invalidToyId) slotOfId.Mutable(ids[i]) = Uint32(i);
+        }
+    }
+
+    bool Insert(ToyId id, const Toy& toy) {
+        if (id == invalidToyId || SlotOf(id) >= 0) return false;
+        if (id >= slotOfId.size()) slotOfId.resize(size_t(id) + 1, invalidSlot);
+        slotOfId.Mutable(id) = Uint32(ids.size());
+        ids.push_back(id);
+        prices.push_back(toy.price.cents);
+        quantities.push_back(toy.quantity);
+        names.push_back(arena->Add(toy.name.data(), toy.name.size()));
+        descriptions.push_back(arena->Add(toy.description.data(), toy.description.size()));
+        nextId = std::max(nextId, id + 1);
+        revision++;
+        return true;
+    }
+
+    bool Remove(ToyId id) {
+        int slot = SlotOf(id);
+        if (slot < 0) return false;
+        Release(names[slot]);
+        Release(descriptions[slot]);
+        size_t last = ids.size() - 1;
+        if (size_t(slot) != last) {
+            ids.Mutable(slot) = ids[last];
+            prices.Mutable(slot) = prices[last];
+            quantities.Mutable(slot) = quantities[last];
+            names.Mutable(slot) = names[last];
+            descriptions.Mutable(slot) = descriptions[last];
+            slotOfId.Mutable(ids[slot]) = Uint32(slot);
+        }
+        ids.pop_back();
+        prices.pop_back();
+        quantities.pop_back();
+        names.pop_back();
+        descriptions.pop_back();
+        slotOfId.Mutable(id) = invalidSlot;
+        revision++;
+        return true;
+    }
+
+    int SlotOf(ToyId id) const {
+        if (id >= slotOfId.size() || slotOfId[id] == invalidSlot) return -1;
+        return int(slotOfId[id]);
+    }
+
+    ToyId IdAt(size_t slot) const {
+        return ids[slot];
+    }
+
+    TextRef Name(size_t slot) const {
+        return names[slot];
+    }
+
+    TextRef Description(size_t slot) const {
+        return descriptions[slot];
+    }
+
+    Money Price(size_t slot) const {
+        return Money::FromCents(prices[slot]);
+    }
+
+    int Quantity(size_t slot) const {
+        return quantities[slot];
+    }
+
+    Toy Get(size_t slot) const {
+        return { names[slot].Str(), descriptions[slot].Str(), Price(slot), quantities[slot] };
+    }
+
+    void SetQuantity(size_t slot, int quantity) {
+        quantities.Mutable(slot) = quantity;
+        revision++;
+    }
+
+    void SetDetails(size_t slot, const std::string& name, const std::string& description, Money price) {
+        if (name.size() != names[slot].size || name.compare(0, std::string::npos, names[slot].data, names[slot].size) != 0) {
+            Release(names[slot]);
+            names.Mutable(slot) = arena->Add(name.data(), name.size());
+        }
+        if (description.size() != descriptions[slot].size ||
+            description.compare(0, std::string::npos, descriptions[slot].data, descriptions[slot].size) != 0) {
+            Release(descriptions[slot]);
+            descriptions.Mutable(slot) = arena->Add(description.data(), description.size());
+        }
+        prices.Mutable(slot) = price.cents;
+        revision++;
+    }
+
+    Money TotalStockValue() const {
+        Sint64 total = 0;
+        for (size_t c = 0; c < prices.ChunkCount(); ++c) {
+            const Sint64* p = prices.ChunkData(c);
+            const Sint32* q = quantities.ChunkData(c);
+            size_t n = prices.ChunkSize(c);
+            for (size_t i = 0; i < n; ++i) {
+                total += p[i] * q[i];
+            }
+        }
+        return Money::FromCents(total);
+    }
+
+    size_t CountOutOfStock() const {
+        size_t count = 0;
+        for (size_t c = 0; c < quantities.ChunkCount(); ++c) {
+            const Sint32* q = quantities.ChunkData(c);
+            size_t n = quantities.ChunkSize(c);
+            for (size_t i = 0; i < n; ++i) {
+                count += q[i] <= 0;
+            }
+        }
+        return count;
+    }
+
+    // Arena bytes held by strings that no slot refers to any more.
+    size_t DeadStringBytes() const {
+        return deadBytes;
+    }
+
+    bool StringsNeedCompaction() const {
+        return deadBytes >= stringArenaCompactBytes && deadBytes * 2 >= arena->Bytes();
+    }
+
+    // Copies the live arena strings into a fresh arena and drops this
+    // inventory's reference to the old one, which copies taken earlier keep
+    // alive. Every TextRef obtained before the call must be re-read.
+    void CompactStrings() {
+        std::shared_ptr<StringArena> fresh = std::make_shared<StringArena>();
+        for (size_t slot = 0; slot < ids.size(); ++slot) {
+            TextRef name = names[slot];
+            TextRef description = descriptions[slot];
+            if (!InCatalog(name)) names.Mutable(slot) = fresh->Add(name.data, name.size);
+            if (!InCatalog(description)) descriptions.Mutable(slot) = fresh->Add(description.data, description.size);
+        }
+        arena = fresh;
+        deadBytes = 0;
+    }
+
+private:
+    bool InCatalog(TextRef text) const {
+        return catalog && catalog->OwnsText(text.data);
+    }
+
+    void Release(TextRef text) {
+        if (!InCatalog(text)) deadBytes += text.size + 1;
+    }
+
+    CowVector<ToyId> ids;
+    CowVector<Sint64> prices;
+    CowVector<Sint32> quantities;
+    CowVector<TextRef> names;
+    CowVector<TextRef> descriptions;
+    CowVector<Uint32> slotOfId;
+    ToyId nextId = 1;
+    Uint64 revision = 0;
+
+    std::shared_ptr<StringArena> arena;
+    std::shared_ptr<Catalog> catalog;
+    size_t deadBytes = 0;
+};
+
+bool WriteCatalog(const std::string& path, const Inventory& inventory, const Ledger& ledger, Uint64 journalSeq);
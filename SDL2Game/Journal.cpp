@@ -0,0 +1,251 @@
+﻿#include "Journal.h"
+
+#include <cstring>
+
+using namespace std;
+
+bool ApplyJournalEntry(Inventory& inventory, Ledger& ledger, const JournalEntry& entry) {
+    int slot = inventory.SlotOf(entry.id);
+    switch (entry.op) {
+    case JournalOp::Add:
+        return inventory.Insert(entry.id, entry.toy);
+    case JournalOp::Delete:
+        return inventory.Remove(entry.id);
+    case JournalOp::Sell:
+        if (slot < 0 || inventory.Quantity(slot) <= 0) return false;
+        ledger.Record({ entry.time, entry.amount.cents, entry.id, 1 });
+        if (inventory.Quantity(slot) == 1) inventory.Remove(entry.id);
+        else inventory.SetQuantity(slot, inventory.Quantity(slot) - 1);
+        return true;
+    case JournalOp::Edit:
+        if (slot < 0) return false;
+        inventory.SetDetails(slot, entry.toy.name, entry.toy.description, entry.toy.price);
+        return true;
+    case JournalOp::Refund:
+        if (slot < 0 || entry.toy.quantity <= 0) return false;
+        ledger.Record({ entry.time, -entry.amount.cents, entry.id, -entry.toy.quantity });
+        inventory.SetQuantity(slot, inventory.Quantity(slot) + entry.toy.quantity);
+        return true;
+    case JournalOp::Checkout:
+        if (entry.lines.empty()) return false;
+        for (const JournalLine& line : entry.lines) {
+            int lineSlot = inventory.SlotOf(line.id);
+            if (lineSlot < 0 || line.quantity <= 0 || line.quantity > inventory.Quantity(lineSlot)) return false;
+        }
+        for (const JournalLine& line : entry.lines) {
+            int lineSlot = inventory.SlotOf(line.id);
+            ledger.Record({ entry.time, line.amount.cents, line.id, line.quantity });
+            if (inventory.Quantity(lineSlot) == line.quantity) inventory.Remove(line.id);
+            else inventory.SetQuantity(lineSlot, inventory.Quantity(lineSlot) - line.quantity);
+        }
+        return true;
+    }
+    return false;
+}
+
+void InvertJournalEntry(const Inventory& inventory, const JournalEntry& entry, vector<JournalEntry>& out) {
+    int slot = inventory.SlotOf(entry.id);
+    JournalEntry inverse;
+    inverse.id = entry.id;
+    switch (entry.op) {
+    case JournalOp::Add:
+        inverse.op = JournalOp::Delete;
+        out.push_back(inverse);
+        break;
+    case JournalOp::Delete:
+        if (slot < 0) break;
+        inverse.op = JournalOp::Add;
+        inverse.toy = inventory.Get(slot);
+        out.push_back(inverse);
+        break;
+    case JournalOp::Sell:
+        if (slot < 0) break;
+        // Selling the last unit removes the toy, so it comes back empty first.
+        if (inventory.Quantity(slot) == 1) {
+            inverse.op = JournalOp::Add;
+            inverse.toy = inventory.Get(slot);
+            inverse.toy.quantity = 0;
+            out.push_back(inverse);
+        }
+        // Booked at the sale's time, so the sale's ledger bucket nets out.
+        inverse.op = JournalOp::Refund;
+        inverse.toy = Toy{ "", "", { 0 }, 1 };
+        inverse.amount = entry.amount;
+        inverse.time = entry.time;
+        out.push_back(inverse);
+        break;
+    case JournalOp::Edit:
+        if (slot < 0) break;
+        inverse.op = JournalOp::Edit;
+        inverse.toy = inventory.Get(slot);
+        out.push_back(inverse);
+        break;
+    case JournalOp::Checkout:
+        for (const JournalLine& line : entry.lines) {
+            int lineSlot = inventory.SlotOf(line.id);
+            if (lineSlot < 0 || inventory.Quantity(lineSlot) != line.quantity) continue;
+            inverse.op = JournalOp::Add;
+            inverse.id = line.id;
+            inverse.toy = inventory.Get(lineSlot);
+            inverse.toy.quantity = 0;
+            out.push_back(inverse);
+        }
+        for (const JournalLine& line : entry.lines) {
+            inverse.op = JournalOp::Refund;
+            inverse.id = line.id;
+            inverse.toy = Toy{ "", "", { 0 }, line.quantity };
+            inverse.amount = line.amount;
+            inverse.time = entry.time;
+            out.push_back(inverse);
+        }
+        break;
+    case JournalOp::Refund:
+        // Only undo produces refunds; redo replays the original sale instead.
+        break;
+    }
+}
+
+Uint32 JournalChecksum(const unsigned char* data, size_t size) {
+    Uint32 h = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void EncodeJournalPayload(JournalWriter& payload, const JournalEntry& entry) {
+    payload.U8(Uint8(entry.op));
+    switch (entry.op) {
+    case JournalOp::Add:
+        payload.U32(entry.id);
+        payload.Str(entry.toy.name);
+        payload.Str(entry.toy.description);
+        payload.I64(entry.toy.price.cents);
+        payload.U32(Uint32(entry.toy.quantity));
+        break;
+    case JournalOp::Delete:
+        payload.U32(entry.id);
+        break;
+    case JournalOp::Sell:
+        payload.U32(entry.id);
+        payload.I64(entry.amount.cents);
+        payload.I64(entry.time);
+        break;
+    case JournalOp::Edit:
+        payload.U32(entry.id);
+        payload.Str(entry.toy.name);
+        payload.Str(entry.toy.description);
+        payload.I64(entry.toy.price.cents);
+        break;
+    case JournalOp::Refund:
+        payload.U32(entry.id);
+        payload.I64(entry.amount.cents);
+        payload.I64(entry.time);
+        payload.U32(Uint32(entry.toy.quantity));
+        break;
+    case JournalOp::Checkout:
+        payload.I64(entry.time);
+        payload.U32(Uint32(entry.lines.size()));
+        for (const JournalLine& line : entry.lines) {
+            payload.U32(line.id);
+            payload.U32(Uint32(line.quantity));
+            payload.I64(line.amount.cents);
+        }
+        break;
+    }
+}
+
+void EncodeJournalEntry(JournalWriter& out, Uint64 seq, const JournalEntry& entry) {
+    JournalWriter payload;
+    EncodeJournalPayload(payload, entry);
+
+    JournalWriter checked;
+    checked.U64(seq);
+    checked.bytes.append(payload.bytes);
+    out.U32(Uint32(payload.bytes.size()));
+    out.U32(JournalChecksum(reinterpret_cast<const unsigned char*>(checked.bytes.data()), checked.bytes.size()));
+    out.bytes.append(checked.bytes);
+}
+
+bool DecodeJournalEntry(const unsigned char* payload, size_t size, JournalEntry& entry) {
+    JournalReader in(payload, size);
+    entry = JournalEntry();
+    entry.op = JournalOp(in.U8());
+    switch (entry.op) {
+    case JournalOp::Add:
+        entry.id = in.U32();
+        entry.toy.name = in.Str();
+        entry.toy.description = in.Str();
+        entry.toy.price = Money::FromCents(in.I64());
+        entry.toy.quantity = int(in.U32());
+        break;
+    case JournalOp::Delete:
+        entry.id = in.U32();
+        break;
+    case JournalOp::Sell:
+        entry.id = in.U32();
+        entry.amount = Money::FromCents(in.I64());
+        entry.time = in.I64();
+        break;
+    case JournalOp::Edit:
+        entry.id = in.U32();
+        entry.toy.name = in.Str();
+        entry.toy.description = in.Str();
+        entry.toy.price = Money::FromCents(in.I64());
+        break;
+    case JournalOp::Refund:
+        entry.id = in.U32();
+        entry.amount = Money::FromCents(in.I64());
+        entry.time = in.I64();
+        entry.toy.quantity = int(in.U32());
+        break;
+    case JournalOp::Checkout: {
+        entry.time = in.I64();
+        Uint32 count = in.U32();
+        // Each line is 16 bytes; a corrupt count must not reserve gigabytes.
+        if (!in.ok || count > size / 16) return false;
+        entry.lines.resize(count);
+        for (JournalLine& line : entry.lines) {
+            line.id = in.U32();
+            line.quantity = Sint32(in.U32());
+            line.amount = Money::FromCents(in.I64());
+        }
+        break;
+    }
+    default:
+        return false;
+    }
+    return in.ok;
+}
+
+JournalReplayResult ReplayJournal(const string& path, Uint64 afterSeq,
+    const function<void(const JournalEntry&)>& apply) {
+    JournalReplayResult result;
+    result.lastSeq = afterSeq;
+    MappedFile file;
+    if (!file.Open(path)) return result;
+
+    const unsigned char* data = file.Data();
+    size_t offset = 0;
+    while (file.Size() - offset >= journalRecordHeaderSize) {
+        Uint32 payloadSize, checksum;
+        Uint64 seq;
+        memcpy(&payloadSize, data + offset, 4);
+        memcpy(&checksum, data + offset + 4, 4);
+        memcpy(&seq, data + offset + 8, 8);
+        if (file.Size() - offset - journalRecordHeaderSize < payloadSize) break;
+        if (JournalChecksum(data + offset + 8, 8 + size_t(payloadSize)) != checksum) break;
+
+        JournalEntry entry;
+        if (!DecodeJournalEntry(data + offset + journalRecordHeaderSize, payloadSize, entry)) break;
+        if (seq > afterSeq) {
+            apply(entry);
+            result.applied++;
+        }
+        result.lastSeq = max(result.lastSeq, seq);
+        offset += journalRecordHeaderSize + payloadSize;
+    }
+    result.validBytes = offset;
+    return result;
+}
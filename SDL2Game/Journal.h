@@ -0,0 +1,309 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Inventory.h"
+#include "Storage.h"
+#include "Trace.h"
+
+enum class JournalOp : Uint8 {
+    Add = 1,
+    Delete = 2,
+    Sell = 3,
+    Edit = 4,
+    // Returns toy.quantity units to stock and books -amount in the ledger.
+    Refund = 5,
+    // Sells every line at once; nothing applies unless every line fits its
+    // stock. Line ids are unique.
+    Checkout = 6
+};
+
+struct JournalLine {
+    ToyId id;
+    Sint32 quantity;
+    Money amount;
+};
+
+struct JournalEntry {
+    JournalOp op = JournalOp::Add;
+    ToyId id = invalidToyId;
+    Toy toy = { "", "", { 0 }, 0 };
+    Money amount = { 0 };
+    Sint64 time = 0;
+    std::vector<JournalLine> lines;
+};
+
+// Every inventory mutation goes through here, both live and during replay.
+bool ApplyJournalEntry(Inventory& inventory, Ledger& ledger, const JournalEntry& entry);
+
+// Appends the entries that revert entry, in the order to apply them. Must
+// run against the inventory as it was before entry.
+void InvertJournalEntry(const Inventory& inventory, const JournalEntry& entry, std::vector<JournalEntry>& out);
+
+// Journal records: [u32 payload size][u32 checksum][u64 seq][payload], where
+// the payload starts with the op byte. The checksum covers seq and payload.
+const size_t journalRecordHeaderSize = 16;
+
+class JournalWriter {
+public:
+    void U8(Uint8 v) {
+        bytes.push_back(char(v));
+    }
+
+    void U32(Uint32 v) {
+        bytes.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    void U64(Uint64 v) {
+        bytes.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    void I64(Sint64 v) {
+        bytes.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    void Str(const std::string& v) {
+        U32(Uint32(v.size()));
+        bytes.append(v);
+    }
+
+    std::string bytes;
+};
+
+class JournalReader {
+public:
+    JournalReader(const unsigned char* data, size_t size) : p(data), end(data + size) {
+    }
+
+    Uint8 U8() {
+        Uint8 v = 0;
+        Read(&v, sizeof(v));
+        return v;
+    }
+
+    Uint32 U32() {
+        Uint32 v = 0;
+        Read(&v, sizeof(v));
+        return v;
+    }
+
+    Uint64 U64() {
+        Uint64 v = 0;
+        Read(&v, sizeof(v));
+        return v;
+    }
+
+    Sint64 I64() {
+        Sint64 v = 0;
+        Read(&v, sizeof(v));
+        return v;
+    }
+
+    std::string Str() {
+        Uint32 size = U32();
+        if (!ok || size_t(end - p) < size) {
+            ok = false;
+            return std::string();
+        }
+        std::string v(reinterpret_cast<const char*>(p), size);
+        p += size;
+        return v;
+    }
+
+    bool ok = true;
+
+private:
+    void Read(void* out, size_t size) {
+        if (!ok || size_t(end - p) < size) {
+            ok = false;
+            return;
+        }
+        memcpy(out, p, size);
+        p += size;
+    }
+
+    const unsigned char* p;
+    const unsigned char* end;
+};
+
+// The record body alone: op byte and fields, without size, checksum or seq.
+void EncodeJournalPayload(JournalWriter& out, const JournalEntry& entry);
+void EncodeJournalEntry(JournalWriter& out, Uint64 seq, const JournalEntry& entry);
+
+bool DecodeJournalEntry(const unsigned char* payload, size_t size, JournalEntry& entry);
+
+struct JournalReplayResult {
+    Uint64 validBytes = 0;
+    Uint64 lastSeq = 0;
+    size_t applied = 0;
+};
+
+// Walks the journal up to the first torn or corrupt record and hands every
+// entry newer than afterSeq to apply.
+JournalReplayResult ReplayJournal(const std::string& path, Uint64 afterSeq,
+    const std::function<void(const JournalEntry&)>& apply);
+
+enum class FsyncPolicy {
+    Never,
+    Commit,
+    Interval
+};
+
+// Append-only write-ahead log. Append() only encodes into a memory buffer;
+// a writer thread group-commits the buffer, syncs according to the policy
+// and performs snapshot compaction, so the UI loop never waits on disk.
+class Journal {
+public:
+    ~Journal() {
+        Close();
+    }
+
+    bool Open(const std::string& journalPath, const std::string& snapshotPath, Uint64 validBytes, Uint64 lastSeq,
+        FsyncPolicy policy, Uint32 groupCommitMs, Uint32 syncIntervalMs) {
+        if (!file.Open(journalPath, false)) {
+            std::cerr << "Journal open error: " << journalPath << std::endl;
+            return false;
+        }
+        file.Truncate(validBytes);
+        this->snapshotPath = snapshotPath;
+        this->policy = policy;
+        this->groupCommitMs = groupCommitMs;
+        this->syncIntervalMs = syncIntervalMs;
+        nextSeq = lastSeq + 1;
+        bytesSinceCompaction = validBytes;
+        stopping = false;
+        writer = std::thread(&Journal::WriterLoop, this);
+        return true;
+    }
+
+    void Append(const JournalEntry& entry) {
+        if (!file.IsOpen()) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t before = pending.bytes.size();
+        EncodeJournalEntry(pending, nextSeq++, entry);
+        bytesSinceCompaction += pending.bytes.size() - before;
+        if (pending.bytes.size() >= groupCommitBytes) wake.notify_one();
+    }
+
+    // Takes a snapshot of the inventory as of the last Append().
+    void RequestCompaction(Inventory snapshot, Ledger ledger) {
+        if (!file.IsOpen()) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        compactionInventory = std::move(snapshot);
+        compactionLedger = std::move(ledger);
+        compactionSeq = nextSeq - 1;
+        compactionCut = pending.bytes.size();
+        compactionRequested = true;
+        bytesSinceCompaction = 0;
+        wake.notify_one();
+    }
+
+    bool IsOpen() const {
+        return file.IsOpen();
+    }
+
+    Uint64 BytesSinceCompaction() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return bytesSinceCompaction;
+    }
+
+    void Close() {
+        if (!writer.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+        file.Close();
+    }
+
+private:
+    void WriterLoop() {
+        tracer.SetThreadName("journal");
+        Uint32 lastSync = SDL_GetTicks();
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake.wait_for(lock, std::chrono::milliseconds(groupCommitMs), [this] {
+                return stopping || compactionRequested || pending.bytes.size() >= groupCommitBytes;
+                });
+            if (stopping && pending.bytes.empty() && !compactionRequested) break;
+
+            std::string batch;
+            batch.swap(pending.bytes);
+            bool compact = compactionRequested;
+            size_t cut = compact ? compactionCut : batch.size();
+            Inventory snapshot;
+            Ledger ledger;
+            Uint64 seq = compactionSeq;
+            if (compact) {
+                std::swap(snapshot, compactionInventory);
+                std::swap(ledger, compactionLedger);
+            }
+            compactionRequested = false;
+            lock.unlock();
+
+            bool dirty = false;
+            if (cut > 0) {
+                TraceZone zone("Journal write");
+                file.Write(batch.data(), cut);
+                dirty = true;
+            }
+            if (compact) {
+                TraceZone zone("Compaction");
+                if (dirty) file.Sync();
+                if (WriteCatalog(snapshotPath, snapshot, ledger, seq)) {
+                    file.Truncate(0);
+                }
+                dirty = true;
+            }
+            if (cut < batch.size()) {
+                TraceZone zone("Journal write");
+                file.Write(batch.data() + cut, batch.size() - cut);
+                dirty = true;
+            }
+            if (dirty) {
+                Uint32 now = SDL_GetTicks();
+                if (policy == FsyncPolicy::Commit || compact ||
+                    (policy == FsyncPolicy::Interval && now - lastSync >= syncIntervalMs)) {
+                    TraceZone zone("Journal sync");
+                    file.Sync();
+                    lastSync = now;
+                }
+            }
+
+            lock.lock();
+        }
+        if (policy != FsyncPolicy::Never) file.Sync();
+    }
+
+    static const size_t groupCommitBytes = 64 * 1024;
+
+    RawFile file;
+    std::string snapshotPath;
+    FsyncPolicy policy = FsyncPolicy::Commit;
+    Uint32 groupCommitMs = 5;
+    Uint32 syncIntervalMs = 1000;
+
+    std::thread writer;
+    std::mutex mutex_;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    JournalWriter pending;
+    Uint64 nextSeq = 1;
+    Uint64 bytesSinceCompaction = 0;
+
+    bool compactionRequested = false;
+    Inventory compactionInventory;
+    Ledger compactionLedger;
+    Uint64 compactionSeq = 0;
+    size_t compactionCut = 0;
+};
@@ -0,0 +1,126 @@
+﻿#include "Layout.h"
+
+#include <algorithm>
+
+#include "Trace.h"
+
+using namespace std;
+
+void WidgetGrid::Build(int width, int height, const vector<pair<Widget, SDL_Rect>>& widgets) {
+    columns = max(1, (width + widgetGridCell - 1) / widgetGridCell);
+    rows = max(1, (height + widgetGridCell - 1) / widgetGridCell);
+    cellStart.assign(size_t(columns) * rows + 1, 0);
+    entries.clear();
+
+    // Two passes over the widgets: count per cell, then fill, so every
+    // cell is a contiguous range of entries.
+    auto ForEachCell = [&](const SDL_Rect& rect, auto&& visit) {
+        if (rect.w <= 0 || rect.h <= 0) return;
+        int x0 = max(0, rect.x / widgetGridCell);
+        int y0 = max(0, rect.y / widgetGridCell);
+        int x1 = min(columns - 1, (rect.x + rect.w - 1) / widgetGridCell);
+        int y1 = min(rows - 1, (rect.y + rect.h - 1) / widgetGridCell);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) visit(size_t(y) * columns + x);
+        }
+    };
+    for (auto& widget : widgets) {
+        ForEachCell(widget.second, [&](size_t cell) { cellStart[cell + 1]++; });
+    }
+    for (size_t i = 1; i < cellStart.size(); ++i) cellStart[i] += cellStart[i - 1];
+    entries.resize(cellStart.back());
+    vector<Uint32> fill(cellStart.begin(), cellStart.end() - 1);
+    for (auto& widget : widgets) {
+        ForEachCell(widget.second, [&](size_t cell) { entries[fill[cell]++] = widget; });
+    }
+}
+
+Widget WidgetGrid::HitTest(int x, int y) const {
+    if (x < 0 || y < 0) return Widget::None;
+    int column = x / widgetGridCell;
+    int row = y / widgetGridCell;
+    if (column >= columns || row >= rows) return Widget::None;
+    size_t cell = size_t(row) * columns + column;
+    for (Uint32 i = cellStart[cell]; i < cellStart[cell + 1]; ++i) {
+        if (IsPointInRect(x, y, entries[i].second)) return entries[i].first;
+    }
+    return Widget::None;
+}
+
+bool UiLayout::Update(int newWidth, int newHeight) {
+    if (newWidth == width && newHeight == height) return false;
+    TraceZone zone("Layout");
+    width = newWidth;
+    height = newHeight;
+    revision++;
+
+    int btnWidth = width / 3;
+    int btnHeight = height / 10;
+    int btnX = (width - btnWidth) / 2;
+    menu.play = { btnX, height / 3, btnWidth, btnHeight };
+    menu.exit = { btnX, height / 3 + btnHeight + 20, btnWidth, btnHeight };
+
+    int sBtnWidth = (width - 90) / 7;
+    int sBtnHeight = 50;
+    int sBtnY = height - sBtnHeight - 20;
+    int startY = height / 10;
+    store.search = { 50, startY, width - 100, 36 };
+    int headerY = startY + 46;
+    int priceX = 50 + (width - 100) * 55 / 100;
+    int quantityX = 50 + (width - 100) * 78 / 100;
+    store.sortName = { 50, headerY, priceX - 50 - 4, 28 };
+    store.sortPrice = { priceX, headerY, quantityX - priceX - 4, 28 };
+    store.sortQuantity = { quantityX, headerY, width - 50 - quantityX, 28 };
+    int listY = headerY + 34;
+    store.list = { 50, listY, width - 100, max(0, sBtnY - 10 - listY) };
+    store.boxHeight = storeRowBoxHeight;
+    store.lineHeight = storeRowBoxHeight + storeRowGap;
+    SDL_Rect* buttons[] = { &store.up, &store.down, &store.add, &store.remove, &store.sell, &store.edit, &store.back };
+    for (int i = 0; i < 7; ++i) {
+        *buttons[i] = { 10 * (i + 1) + sBtnWidth * i, sBtnY, sBtnWidth, sBtnHeight };
+    }
+
+    int lineHeight = 40;
+    int inputFieldHeight = 36;
+    int marginTop = height / 5;
+    int inputWidth = width - 100;
+    edit.nameLabel = { 50, marginTop - 28, 300, 24 };
+    edit.nameInput = { 50, marginTop, inputWidth, inputFieldHeight };
+    edit.priceLabel = { 50, marginTop + (lineHeight * 2) - 28, 300, 24 };
+    edit.priceInput = { 50, marginTop + (lineHeight * 2), inputWidth, inputFieldHeight };
+    edit.descLabel = { 50, marginTop + (lineHeight * 4) - 28, 300, 24 };
+    edit.descInput = { 50, marginTop + (lineHeight * 4), inputWidth, inputFieldHeight * 3 };
+
+    int editBtnWidth = 150;
+    int editBtnHeight = 50;
+    int editBtnY = height - 80;
+    edit.save = { width / 2 - editBtnWidth - 20, editBtnY, editBtnWidth, editBtnHeight };
+    edit.cancel = { width / 2 + 20, editBtnY, editBtnWidth, editBtnHeight };
+
+    ListView track;
+    track.viewport = store.list;
+    menuGrid.Build(width, height, { { Widget::MenuPlay, menu.play }, { Widget::MenuExit, menu.exit } });
+    storeGrid.Build(width, height, {
+        { Widget::StoreUp, store.up }, { Widget::StoreDown, store.down }, { Widget::StoreAdd, store.add },
+        { Widget::StoreDelete, store.remove }, { Widget::StoreSell, store.sell }, { Widget::StoreEdit, store.edit },
+        { Widget::StoreBack, store.back }, { Widget::StoreSearch, store.search },
+        { Widget::StoreSortName, store.sortName }, { Widget::StoreSortPrice, store.sortPrice },
+        { Widget::StoreSortQuantity, store.sortQuantity },
+        { Widget::StoreScrollbar, track.ScrollTrack() },
+        { Widget::StoreList, store.list } });
+    editGrid.Build(width, height, {
+        { Widget::EditName, edit.nameInput }, { Widget::EditPrice, edit.priceInput },
+        { Widget::EditDescription, edit.descInput }, { Widget::EditSave, edit.save }, { Widget::EditCancel, edit.cancel } });
+    return true;
+}
+
+void UiLayout::Apply(ListView& view, int itemCount) {
+    if (appliedRevision == revision && appliedItems == itemCount) return;
+    view.viewport = store.list;
+    view.lineHeight = store.lineHeight;
+    view.boxHeight = store.boxHeight;
+    view.itemCount = itemCount;
+    view.ClampScroll();
+    appliedRevision = revision;
+    appliedItems = itemCount;
+}
@@ -0,0 +1,114 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <vector>
+
+#include "ListView.h"
+
+enum class Widget : Uint8 {
+    None,
+    MenuPlay,
+    MenuExit,
+    StoreSearch,
+    StoreSortName,
+    StoreSortPrice,
+    StoreSortQuantity,
+    StoreList,
+    StoreScrollbar,
+    StoreUp,
+    StoreDown,
+    StoreAdd,
+    StoreDelete,
+    StoreSell,
+    StoreEdit,
+    StoreBack,
+    EditName,
+    EditPrice,
+    EditDescription,
+    EditSave,
+    EditCancel
+};
+
+const int widgetGridCell = 32;
+
+// Uniform grid over the window: each cell lists the widgets overlapping it,
+// so a point query only tests the few rects of one cell. Earlier widgets
+// win where rects overlap.
+class WidgetGrid {
+public:
+    void Build(int width, int height, const std::vector<std::pair<Widget, SDL_Rect>>& widgets);
+
+    Widget HitTest(int x, int y) const;
+
+private:
+    int columns = 0;
+    int rows = 0;
+    std::vector<Uint32> cellStart;
+    std::vector<std::pair<Widget, SDL_Rect>> entries;
+};
+
+struct MenuLayout {
+    SDL_Rect play;
+    SDL_Rect exit;
+};
+
+// A STORE row box fits the name line and two description lines; rows are
+// spaced by the box plus a gap.
+const int storeRowBoxHeight = 84;
+const int storeRowGap = 12;
+
+struct StoreLayout {
+    SDL_Rect search;
+    SDL_Rect sortName;
+    SDL_Rect sortPrice;
+    SDL_Rect sortQuantity;
+    SDL_Rect list;
+    int lineHeight;
+    int boxHeight;
+    SDL_Rect up;
+    SDL_Rect down;
+    SDL_Rect add;
+    SDL_Rect remove;
+    SDL_Rect sell;
+    SDL_Rect edit;
+    SDL_Rect back;
+};
+
+struct EditLayout {
+    SDL_Rect nameLabel;
+    SDL_Rect nameInput;
+    SDL_Rect priceLabel;
+    SDL_Rect priceInput;
+    SDL_Rect descLabel;
+    SDL_Rect descInput;
+    SDL_Rect save;
+    SDL_Rect cancel;
+};
+
+// Widget geometry of every screen, shared by hit-testing and drawing, plus
+// a hit-test grid per screen. Nothing here depends on the content, so it
+// only changes with the window size.
+class UiLayout {
+public:
+    // Returns true when the size changed and the rects were recomputed.
+    bool Update(int width, int height);
+
+    // Copies the list geometry into view when the layout or the item count
+    // changed since the last call.
+    void Apply(ListView& view, int itemCount);
+
+    MenuLayout menu;
+    StoreLayout store;
+    EditLayout edit;
+
+    WidgetGrid menuGrid;
+    WidgetGrid storeGrid;
+    WidgetGrid editGrid;
+
+private:
+    int width = -1;
+    int height = -1;
+    Uint64 revision = 0;
+    Uint64 appliedRevision = ~0ULL;
+    int appliedItems = -1;
+};
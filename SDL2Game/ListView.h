@@ -0,0 +1,92 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <algorithm>
+
+inline bool IsPointInRect(int px, int py, const SDL_Rect& rect) {
+    return px >= rect.x && px < rect.x + rect.w && py >= rect.y && py < rect.y + rect.h;
+}
+
+const int scrollbarGap = 12;
+const int scrollbarWidth = 10;
+const int minThumbHeight = 20;
+
+// Vertical list of uniform rows. Only rows intersecting the viewport are
+// laid out, so hit-testing and drawing cost O(visible rows).
+struct ListView {
+    SDL_Rect viewport = { 0, 0, 0, 0 };
+    int lineHeight = 1;
+    int boxHeight = 1;
+    int itemCount = 0;
+    int scrollY = 0;
+
+    int ContentHeight() const {
+        return itemCount * lineHeight;
+    }
+
+    int MaxScroll() const {
+        return std::max(0, ContentHeight() - viewport.h);
+    }
+
+    int PageRows() const {
+        return std::max(1, viewport.h / lineHeight);
+    }
+
+    void ClampScroll() {
+        scrollY = std::min(std::max(scrollY, 0), MaxScroll());
+    }
+
+    void ScrollBy(int dy) {
+        scrollY += dy;
+        ClampScroll();
+    }
+
+    void EnsureVisible(int index) {
+        if (index < 0 || index >= itemCount) return;
+        int top = index * lineHeight;
+        if (top < scrollY) scrollY = top;
+        else if (top + boxHeight > scrollY + viewport.h) scrollY = top + boxHeight - viewport.h;
+        ClampScroll();
+    }
+
+    int FirstVisible() const {
+        return std::min(itemCount, scrollY / lineHeight);
+    }
+
+    int EndVisible() const {
+        return std::min(itemCount, (scrollY + viewport.h + lineHeight - 1) / lineHeight);
+    }
+
+    SDL_Rect RowRect(int index) const {
+        return { viewport.x, viewport.y + index * lineHeight - scrollY, viewport.w, boxHeight };
+    }
+
+    int HitTest(int x, int y) const {
+        if (x < viewport.x || x >= viewport.x + viewport.w || y < viewport.y || y >= viewport.y + viewport.h) return -1;
+        int offset = y - viewport.y + scrollY;
+        int index = offset / lineHeight;
+        if (index >= itemCount || offset % lineHeight >= boxHeight) return -1;
+        return index;
+    }
+
+    SDL_Rect ScrollTrack() const {
+        return { viewport.x + viewport.w + scrollbarGap, viewport.y, scrollbarWidth, viewport.h };
+    }
+
+    SDL_Rect ScrollThumb() const {
+        SDL_Rect track = ScrollTrack();
+        int content = std::max(1, ContentHeight());
+        int thumbHeight = std::min(track.h, std::max(minThumbHeight, int(Sint64(track.h) * track.h / content)));
+        int range = track.h - thumbHeight;
+        int maxScroll = MaxScroll();
+        int thumbY = track.y + (maxScroll > 0 ? int(Sint64(range) * scrollY / maxScroll) : 0);
+        return { track.x, thumbY, track.w, thumbHeight };
+    }
+
+    void ScrollToThumb(int thumbY) {
+        SDL_Rect track = ScrollTrack();
+        int range = track.h - ScrollThumb().h;
+        scrollY = range > 0 ? int(Sint64(thumbY - track.y) * MaxScroll() / range) : 0;
+        ClampScroll();
+    }
+};
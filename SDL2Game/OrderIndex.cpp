@@ -0,0 +1,79 @@
+﻿#include "OrderIndex.h"
+
+#include "Trace.h"
+
+using namespace std;
+
+void InventoryOrder::Require(const Inventory& inventory, SortColumn column) {
+    if (column == SortColumn::Name && !nameBuilt) {
+        TraceZone zone("Sort build");
+        vector<pair<TextRef, ToyId>> items;
+        items.reserve(inventory.Size());
+        for (size_t slot = 0; slot < inventory.Size(); ++slot) items.emplace_back(inventory.Name(slot), inventory.IdAt(slot));
+        names.Build(move(items));
+        nameBuilt = true;
+    }
+    else if ((column == SortColumn::Price && !priceBuilt) || (column == SortColumn::Quantity && !quantityBuilt)) {
+        TraceZone zone("Sort build");
+        bool price = column == SortColumn::Price;
+        vector<pair<Sint64, ToyId>> items;
+        items.reserve(inventory.Size());
+        for (size_t slot = 0; slot < inventory.Size(); ++slot) {
+            items.emplace_back(price ? inventory.Price(slot).cents : inventory.Quantity(slot), inventory.IdAt(slot));
+        }
+        (price ? prices : quantities).Build(move(items));
+        (price ? priceBuilt : quantityBuilt) = true;
+    }
+}
+
+void InventoryOrder::Update(const Inventory& inventory, ToyId id) {
+    int slot = inventory.SlotOf(id);
+    if (slot < 0) {
+        names.Erase(id);
+        prices.Erase(id);
+        quantities.Erase(id);
+        return;
+    }
+    if (nameBuilt) names.Update(id, inventory.Name(slot));
+    if (priceBuilt) prices.Update(id, inventory.Price(slot).cents);
+    if (quantityBuilt) quantities.Update(id, inventory.Quantity(slot));
+}
+
+ToyId InventoryOrder::At(SortColumn column, size_t rank) const {
+    switch (column) {
+    case SortColumn::Name:
+        return names.At(rank);
+    case SortColumn::Price:
+        return prices.At(rank);
+    case SortColumn::Quantity:
+        return quantities.At(rank);
+    default:
+        return invalidToyId;
+    }
+}
+
+int InventoryOrder::Rank(SortColumn column, ToyId id) const {
+    switch (column) {
+    case SortColumn::Name:
+        return names.Rank(id);
+    case SortColumn::Price:
+        return prices.Rank(id);
+    case SortColumn::Quantity:
+        return quantities.Rank(id);
+    default:
+        return -1;
+    }
+}
+
+bool InventoryOrder::Less(SortColumn column, ToyId a, ToyId b) const {
+    switch (column) {
+    case SortColumn::Name:
+        return names.Less(a, b);
+    case SortColumn::Price:
+        return prices.Less(a, b);
+    case SortColumn::Quantity:
+        return quantities.Less(a, b);
+    default:
+        return a < b;
+    }
+}
@@ -0,0 +1,268 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "Inventory.h"
+#include "Search.h"
+
+// Sorted set of (key, id) pairs as a treap whose nodes count their subtree,
+// so insert, erase, the id at a rank and the rank of an id are all
+// O(log n). Ties on the key are broken by id, which keeps the order total
+// and stable across updates.
+template <typename Key, typename KeyLess>
+class OrderIndex {
+public:
+    OrderIndex() {
+        nodes.push_back(Node());
+    }
+
+    size_t Size() const {
+        return nodes[root].size;
+    }
+
+    bool Contains(ToyId id) const {
+        return id < nodeOfId.size() && nodeOfId[id] != 0;
+    }
+
+    // items may be in any order.
+    void Build(std::vector<std::pair<Key, ToyId>> items) {
+        nodes.assign(1, Node());
+        freeNodes.clear();
+        nodeOfId.clear();
+        std::sort(items.begin(), items.end(), [this](const std::pair<Key, ToyId>& a, const std::pair<Key, ToyId>& b) {
+            return Before(a.first, a.second, b.first, b.second);
+            });
+
+        // Cartesian tree over the sorted items: a stack holds the right
+        // spine, and each new node adopts the popped lower-priority tail.
+        std::vector<Uint32> spine;
+        for (auto& item : items) {
+            Uint32 node = NewNode(item.first, item.second);
+            Uint32 last = 0;
+            while (!spine.empty() && nodes[spine.back()].priority < nodes[node].priority) {
+                last = spine.back();
+                spine.pop_back();
+            }
+            nodes[node].left = last;
+            if (!spine.empty()) nodes[spine.back()].right = node;
+            spine.push_back(node);
+        }
+        root = spine.empty() ? 0 : spine.front();
+        FixSizes(root);
+    }
+
+    void Insert(ToyId id, const Key& key) {
+        Erase(id);
+        Uint32 left, right;
+        Split(root, key, id, left, right);
+        root = Merge(Merge(left, NewNode(key, id)), right);
+    }
+
+    void Erase(ToyId id) {
+        if (!Contains(id)) return;
+        Uint32 node = nodeOfId[id];
+        Uint32 left, right, single, rest;
+        Split(root, nodes[node].key, id, left, right);
+        SplitFirst(right, single, rest);
+        root = Merge(left, rest);
+        nodeOfId[id] = 0;
+        nodes[node] = Node();
+        freeNodes.push_back(node);
+    }
+
+    // Re-positions id only when its key actually changed.
+    void Update(ToyId id, const Key& key) {
+        if (Contains(id)) {
+            const Key& current = nodes[nodeOfId[id]].key;
+            if (!less(current, key) && !less(key, current)) return;
+        }
+        Insert(id, key);
+    }
+
+    ToyId At(size_t rank) const {
+        Uint32 node = root;
+        while (node) {
+            Uint32 leftSize = nodes[nodes[node].left].size;
+            if (rank < leftSize) {
+                node = nodes[node].left;
+            }
+            else if (rank == leftSize) {
+                return nodes[node].id;
+            }
+            else {
+                rank -= leftSize + 1;
+                node = nodes[node].right;
+            }
+        }
+        return invalidToyId;
+    }
+
+    // -1 when id is not in the index.
+    int Rank(ToyId id) const {
+        if (!Contains(id)) return -1;
+        const Node& target = nodes[nodeOfId[id]];
+        size_t rank = 0;
+        Uint32 node = root;
+        while (node) {
+            const Node& n = nodes[node];
+            if (n.id == id) return int(rank + nodes[n.left].size);
+            if (Before(target.key, id, n.key, n.id)) {
+                node = n.left;
+            }
+            else {
+                rank += nodes[n.left].size + 1;
+                node = n.right;
+            }
+        }
+        return -1;
+    }
+
+    // Order of two indexed ids.
+    bool Less(ToyId a, ToyId b) const {
+        return Before(nodes[nodeOfId[a]].key, a, nodes[nodeOfId[b]].key, b);
+    }
+
+private:
+    struct Node {
+        Key key = Key();
+        ToyId id = invalidToyId;
+        Uint32 priority = 0;
+        Uint32 size = 0;
+        Uint32 left = 0;
+        Uint32 right = 0;
+    };
+
+    bool Before(const Key& a, ToyId aId, const Key& b, ToyId bId) const {
+        if (less(a, b)) return true;
+        if (less(b, a)) return false;
+        return aId < bId;
+    }
+
+    Uint32 NewNode(const Key& key, ToyId id) {
+        Uint32 node;
+        if (!freeNodes.empty()) {
+            node = freeNodes.back();
+            freeNodes.pop_back();
+        }
+        else {
+            node = Uint32(nodes.size());
+            nodes.push_back(Node());
+        }
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        Node& n = nodes[node];
+        n.key = key;
+        n.id = id;
+        n.priority = seed;
+        n.size = 1;
+        n.left = n.right = 0;
+        if (id >= nodeOfId.size()) nodeOfId.resize(size_t(id) + 1, 0);
+        nodeOfId[id] = node;
+        return node;
+    }
+
+    void Pull(Uint32 node) {
+        nodes[node].size = 1 + nodes[nodes[node].left].size + nodes[nodes[node].right].size;
+    }
+
+    void FixSizes(Uint32 node) {
+        if (!node) return;
+        FixSizes(nodes[node].left);
+        FixSizes(nodes[node].right);
+        Pull(node);
+    }
+
+    // left gets the pairs ordered before (key, id), right the rest.
+    void Split(Uint32 node, const Key& key, ToyId id, Uint32& left, Uint32& right) {
+        if (!node) {
+            left = right = 0;
+            return;
+        }
+        if (Before(nodes[node].key, nodes[node].id, key, id)) {
+            Split(nodes[node].right, key, id, nodes[node].right, right);
+            left = node;
+        }
+        else {
+            Split(nodes[node].left, key, id, left, nodes[node].left);
+            right = node;
+        }
+        Pull(node);
+    }
+
+    void SplitFirst(Uint32 node, Uint32& first, Uint32& rest) {
+        if (!node) {
+            first = rest = 0;
+            return;
+        }
+        if (!nodes[node].left) {
+            first = node;
+            rest = nodes[node].right;
+            nodes[node].right = 0;
+            Pull(node);
+            return;
+        }
+        SplitFirst(nodes[node].left, first, nodes[node].left);
+        rest = node;
+        Pull(node);
+    }
+
+    Uint32 Merge(Uint32 a, Uint32 b) {
+        if (!a || !b) return a ? a : b;
+        if (nodes[a].priority > nodes[b].priority) {
+            nodes[a].right = Merge(nodes[a].right, b);
+            Pull(a);
+            return a;
+        }
+        nodes[b].left = Merge(a, nodes[b].left);
+        Pull(b);
+        return b;
+    }
+
+    KeyLess less;
+    std::vector<Node> nodes;
+    std::vector<Uint32> freeNodes;
+    std::vector<Uint32> nodeOfId;
+    Uint32 root = 0;
+    Uint32 seed = 2463534242u;
+};
+
+struct FoldedTextLess {
+    bool operator()(TextRef a, TextRef b) const {
+        return CompareFolded(a, b) < 0;
+    }
+};
+
+enum class SortColumn {
+    None,
+    Name,
+    Price,
+    Quantity
+};
+
+// STORE sort orders. An index is built the first time its column is
+// sorted and from then on kept current by Update after every change.
+class InventoryOrder {
+public:
+    void Require(const Inventory& inventory, SortColumn column);
+
+    // Brings every built index in line with the current state of id,
+    // which may have been added, changed or removed.
+    void Update(const Inventory& inventory, ToyId id);
+
+    ToyId At(SortColumn column, size_t rank) const;
+    int Rank(SortColumn column, ToyId id) const;
+    bool Less(SortColumn column, ToyId a, ToyId b) const;
+
+private:
+    bool nameBuilt = false;
+    bool priceBuilt = false;
+    bool quantityBuilt = false;
+    OrderIndex<TextRef, FoldedTextLess> names;
+    OrderIndex<Sint64, std::less<Sint64>> prices;
+    OrderIndex<Sint64, std::less<Sint64>> quantities;
+};
@@ -0,0 +1,96 @@
+﻿#include "Paragraph.h"
+
+#include <algorithm>
+
+using namespace std;
+
+size_t LineAt(const vector<TextLine>& lines, size_t offset) {
+    auto it = upper_bound(lines.begin(), lines.end(), offset,
+        [](size_t value, const TextLine& line) { return value < line.start; });
+    return it == lines.begin() ? 0 : size_t(it - lines.begin()) - 1;
+}
+
+const vector<TextLine>& ParagraphCache::Wrap(TTF_Font* font, const char* text, size_t size, int width) {
+    Key key = { HashUTF8(text, size), size, width, font };
+    auto it = index.find(key);
+    if (it != index.end()) {
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->lines;
+    }
+
+    entries.push_front(Entry{ key, {} });
+    Break(font, text, size, width, entries.front().lines);
+    index[key] = entries.begin();
+    while (entries.size() > capacity) {
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+    return entries.front().lines;
+}
+
+// Greedy: a line ends at the last space before the word that overflows, or
+// inside a word that is wider than the whole line. '\n' always ends a line.
+void ParagraphCache::Break(TTF_Font* font, const char* text, size_t size, int width, vector<TextLine>& lines) {
+    TraceZone zone("Wrap");
+    const char* p = text;
+    const char* end = text + size;
+    size_t lineStart = 0;
+    size_t spaceStart = 0;
+    size_t wordStart = 0;
+    int penX = 0;
+    Uint32 prev = 0;
+    while (p < end) {
+        size_t offset = size_t(p - text);
+        Uint32 cp = DecodeUTF8(p, end);
+        if (cp == '\n') {
+            lines.push_back(TextLine{ Uint32(lineStart), Uint32(offset - lineStart) });
+            lineStart = spaceStart = wordStart = size_t(p - text);
+            penX = 0;
+            prev = 0;
+            continue;
+        }
+        if (cp == ' ') {
+            if (prev != ' ') spaceStart = offset;
+        }
+        else if (prev == ' ') {
+            wordStart = offset;
+        }
+
+        int advance = atlas.Advance(font, prev, cp);
+        if (cp != ' ' && penX + advance > width && offset > lineStart) {
+            if (wordStart > lineStart && spaceStart > lineStart) {
+                lines.push_back(TextLine{ Uint32(lineStart), Uint32(spaceStart - lineStart) });
+                lineStart = wordStart;
+                // Re-measure the carried word; it is never longer than the line.
+                penX = 0;
+                Uint32 carried = 0;
+                for (const char* q = text + wordStart; q < text + offset;) {
+                    Uint32 c = DecodeUTF8(q, end);
+                    penX += atlas.Advance(font, carried, c);
+                    carried = c;
+                }
+                advance = atlas.Advance(font, carried, cp);
+            }
+            else {
+                lines.push_back(TextLine{ Uint32(lineStart), Uint32(offset - lineStart) });
+                lineStart = wordStart = offset;
+                penX = 0;
+                advance = atlas.Advance(font, 0, cp);
+            }
+            spaceStart = lineStart;
+        }
+        penX += advance;
+        prev = cp;
+    }
+    lines.push_back(TextLine{ Uint32(lineStart), Uint32(size - lineStart) });
+}
+
+int ParagraphCache::Draw(TTF_Font* font, const char* text, size_t size, SDL_Color color, int x, int y, int width, int maxLines) {
+    const vector<TextLine>& lines = Wrap(font, text, size, width);
+    int count = maxLines < 0 ? int(lines.size()) : min(maxLines, int(lines.size()));
+    int lineSkip = TTF_FontLineSkip(font);
+    for (int i = 0; i < count; ++i) {
+        atlas.DrawText(font, text + lines[i].start, lines[i].size, color, x, y + i * lineSkip, width);
+    }
+    return count;
+}
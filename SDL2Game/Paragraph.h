@@ -0,0 +1,79 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "Render.h"
+
+// One wrapped line: bytes [start, start + size) of the paragraph. Spaces at
+// a soft break belong to neither line.
+struct TextLine {
+    Uint32 start;
+    Uint32 size;
+};
+
+// Index of the line holding byte offset; lines must not be empty.
+size_t LineAt(const std::vector<TextLine>& lines, size_t offset);
+
+const size_t paragraphCacheEntries = 4096;
+
+// Word wrap of UTF-8 text to a pixel width with the atlas's glyph advances.
+// Results are kept in an LRU keyed by (text hash, width, font), so an edited
+// text or a new width simply misses; Clear() drops everything on resize.
+class ParagraphCache {
+public:
+    explicit ParagraphCache(GlyphAtlas& atlas, size_t capacity = paragraphCacheEntries)
+        : atlas(atlas), capacity(capacity) {
+    }
+
+    // Always at least one line. The result stays valid until the next Wrap().
+    const std::vector<TextLine>& Wrap(TTF_Font* font, const char* text, size_t size, int width);
+
+    // Draws the first maxLines lines (all with -1) and returns how many it drew.
+    int Draw(TTF_Font* font, const char* text, size_t size, SDL_Color color, int x, int y, int width, int maxLines = -1);
+
+    void Clear() {
+        entries.clear();
+        index.clear();
+    }
+
+    size_t Size() const {
+        return entries.size();
+    }
+
+private:
+    struct Key {
+        Uint64 hash;
+        size_t size;
+        int width;
+        TTF_Font* font;
+
+        bool operator==(const Key& other) const {
+            return hash == other.hash && size == other.size && width == other.width && font == other.font;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            size_t h = size_t(key.hash);
+            h ^= std::hash<int>()(key.width) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            h ^= std::hash<const void*>()(key.font) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            return h;
+        }
+    };
+
+    struct Entry {
+        Key key;
+        std::vector<TextLine> lines;
+    };
+
+    void Break(TTF_Font* font, const char* text, size_t size, int width, std::vector<TextLine>& lines);
+
+    GlyphAtlas& atlas;
+    size_t capacity;
+    std::list<Entry> entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+};
@@ -0,0 +1,127 @@
+﻿#include "Perf.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+
+using namespace std;
+
+// Counted by the operator new in HeapCounter.cpp, which only the app and
+// bench executables link.
+thread_local Uint64 heapAllocationsOnThread = 0;
+
+Uint64 HeapAllocationCount() {
+    return heapAllocationsOnThread;
+}
+
+// Nearest-rank percentile of an ascending sample.
+template <typename T>
+static T Percentile(const vector<T>& sorted, double p) {
+    size_t rank = size_t(ceil(p * sorted.size()));
+    return sorted[min(sorted.size(), max(rank, size_t(1))) - 1];
+}
+
+void FrameStats::Add(const FrameSample& sample) {
+    frameMs.push_back(sample.frameMs);
+    drawCalls.push_back(sample.counters.DrawCalls());
+    allocations.push_back(sample.allocations);
+    textureUploads += sample.counters.textureUploads;
+    textureCreations += sample.counters.textureCreations;
+}
+
+void FrameStats::Report(ostream& out) const {
+    if (frameMs.empty()) return;
+    vector<double> sortedMs = frameMs;
+    sort(sortedMs.begin(), sortedMs.end());
+    vector<Uint32> sortedCalls = drawCalls;
+    sort(sortedCalls.begin(), sortedCalls.end());
+    vector<Uint64> sortedAllocations = allocations;
+    sort(sortedAllocations.begin(), sortedAllocations.end());
+    double totalMs = 0.0;
+    for (double ms : frameMs) totalMs += ms;
+    out << fixed << setprecision(3)
+        << "Frames: " << frameMs.size() << ", mean " << totalMs / frameMs.size() << " ms" << endl
+        << "Frame time ms: p50 " << Percentile(sortedMs, 0.50) << ", p95 " << Percentile(sortedMs, 0.95)
+        << ", p99 " << Percentile(sortedMs, 0.99) << ", max " << sortedMs.back() << endl
+        << "Draw calls per frame: p50 " << Percentile(sortedCalls, 0.50) << ", p99 " << Percentile(sortedCalls, 0.99)
+        << ", max " << sortedCalls.back() << endl
+        << "Heap allocations per frame on the UI thread: p50 " << Percentile(sortedAllocations, 0.50)
+        << ", p99 " << Percentile(sortedAllocations, 0.99) << ", max " << sortedAllocations.back() << endl
+        << "Texture uploads: " << textureUploads << " (" << textureCreations << " textures created)" << endl;
+    out.unsetf(ios::floatfield);
+}
+
+void PerfHud::AddFrame(const FrameSample& sample, Uint64 frameStart) {
+    samples[next] = sample;
+    starts[next] = frameStart;
+    next = (next + 1) % perfHudHistory;
+    count = min(count + 1, perfHudHistory);
+}
+
+double PerfHud::Fps() const {
+    if (count < 2) return 0.0;
+    Uint64 newest = starts[(next + perfHudHistory - 1) % perfHudHistory];
+    Uint64 oldest = starts[(next + perfHudHistory - count) % perfHudHistory];
+    if (newest == oldest) return 0.0;
+    return (count - 1) * double(SDL_GetPerformanceFrequency()) / double(newest - oldest);
+}
+
+void PerfHud::Draw(ShapeBatch& shapes, GlyphAtlas& atlas, TTF_Font* font, const TextCacheStats& cacheStats, int winWidth) const {
+    if (!visible || count == 0) return;
+
+    // Bars are scaled so that two 60 Hz frames fill the graph.
+    const int barWidth = 2;
+    const int graphHeight = 60;
+    const double graphMs = 1000.0 / 30.0;
+    const double budgetMs = 1000.0 / 60.0;
+    const int lines = 5;
+
+    const FrameSample& last = samples[(next + perfHudHistory - 1) % perfHudHistory];
+    double maxMs = 0.0;
+    for (int i = 0; i < count; ++i) {
+        maxMs = max(maxMs, samples[i].frameMs);
+    }
+
+    int lineHeight = TTF_FontHeight(font);
+    SDL_Rect panel = { 0, 10, barWidth * perfHudHistory + 16, lines * lineHeight + graphHeight + 20 };
+    panel.x = winWidth - panel.w - 10;
+    shapes.AddRect(panel, SDL_Color{ 0, 0, 0, 180 });
+
+    SDL_Color textColor = { 230, 230, 230, 255 };
+    int x = panel.x + 8;
+    int y = panel.y + 6;
+    char line[128];
+    auto DrawLine = [&]() {
+        atlas.DrawText(font, line, strlen(line), textColor, x, y, panel.w - 16);
+        y += lineHeight;
+    };
+
+    Uint64 lookups = cacheStats.hits + cacheStats.misses;
+    snprintf(line, sizeof(line), "%.1f FPS   %.2f ms   max %.2f ms", Fps(), last.frameMs, maxMs);
+    DrawLine();
+    snprintf(line, sizeof(line), "RenderCopy %u   RenderGeometry %u",
+        unsigned(last.counters.copyCalls), unsigned(last.counters.geometryCalls));
+    DrawLine();
+    snprintf(line, sizeof(line), "textures created %u   uploads %u",
+        unsigned(last.counters.textureCreations), unsigned(last.counters.textureUploads));
+    DrawLine();
+    snprintf(line, sizeof(line), "heap allocations %llu (UI thread)", static_cast<unsigned long long>(last.allocations));
+    DrawLine();
+    snprintf(line, sizeof(line), "text cache %u%% hit, %u KiB   atlas %d pages, %u glyphs",
+        unsigned(lookups ? cacheStats.hits * 100 / lookups : 0), unsigned(cacheStats.bytes / 1024),
+        atlas.PageCount(), unsigned(atlas.GlyphCount()));
+    DrawLine();
+
+    SDL_Rect graph = { x, y + 4, barWidth * perfHudHistory, graphHeight };
+    shapes.AddRect(graph, SDL_Color{ 40, 40, 60, 200 });
+    for (int i = 0; i < count; ++i) {
+        const FrameSample& sample = samples[(next + perfHudHistory - count + i) % perfHudHistory];
+        int h = min(graphHeight, max(1, int(sample.frameMs / graphMs * graphHeight)));
+        SDL_Color color = sample.frameMs <= budgetMs ? SDL_Color{ 120, 220, 120, 255 }
+            : sample.frameMs <= graphMs ? SDL_Color{ 230, 200, 90, 255 } : SDL_Color{ 240, 90, 90, 255 };
+        shapes.AddRect({ graph.x + barWidth * (perfHudHistory - count + i), graph.y + graphHeight - h, barWidth, h }, color);
+    }
+    int budgetY = graph.y + graphHeight - int(budgetMs / graphMs * graphHeight);
+    shapes.AddRect({ graph.x, budgetY, graph.w, 1 }, SDL_Color{ 255, 255, 255, 140 });
+}
@@ -0,0 +1,66 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <ostream>
+#include <vector>
+
+#include "Render.h"
+
+// Calls to the global operator new so far on the calling thread; always 0
+// in targets that do not link HeapCounter.cpp.
+Uint64 HeapAllocationCount();
+
+struct FrameSample {
+    double frameMs = 0.0;
+    RenderCounters counters;
+    Uint64 allocations = 0;
+};
+
+// Every frame of a run, reported as percentiles at the end.
+class FrameStats {
+public:
+    void Add(const FrameSample& sample);
+
+    size_t Frames() const {
+        return frameMs.size();
+    }
+
+    void Report(std::ostream& out) const;
+
+private:
+    std::vector<double> frameMs;
+    std::vector<Uint32> drawCalls;
+    std::vector<Uint64> allocations;
+    Uint64 textureUploads = 0;
+    Uint64 textureCreations = 0;
+};
+
+const int perfHudHistory = 120;
+
+// F3 overlay: a rolling frame-time graph over the last perfHudHistory frames
+// plus the counters of the most recent one.
+class PerfHud {
+public:
+    void Toggle() {
+        visible = !visible;
+    }
+
+    bool Visible() const {
+        return visible;
+    }
+
+    // frameStart is the SDL_GetPerformanceCounter() value at the frame start.
+    void AddFrame(const FrameSample& sample, Uint64 frameStart);
+
+    void Draw(ShapeBatch& shapes, GlyphAtlas& atlas, TTF_Font* font, const TextCacheStats& cacheStats, int winWidth) const;
+
+private:
+    double Fps() const;
+
+    bool visible = false;
+    FrameSample samples[perfHudHistory];
+    Uint64 starts[perfHudHistory] = {};
+    int next = 0;
+    int count = 0;
+};
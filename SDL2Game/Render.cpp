@@ -0,0 +1,48 @@
+﻿#include "Render.h"
+
+using namespace std;
+
+RenderCounters renderCounters;
+
+SDL_Texture* CreateTextTexture(SDL_Renderer* renderer, TTF_Font* font, const string& text, SDL_Color color) {
+    TraceZone zone("Rasterize text");
+    SDL_Surface* surface = TTF_RenderUTF8_Blended(font, text.c_str(), color);
+    if (!surface) {
+        cerr << "TTF_RenderUTF8_Blended Error: " << TTF_GetError() << endl;
+        return nullptr;
+    }
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_FreeSurface(surface);
+    if (texture) {
+        renderCounters.textureCreations++;
+        renderCounters.textureUploads++;
+    }
+    return texture;
+}
+
+Uint64 HashUTF8(const string& text) {
+    return HashUTF8(text.data(), text.size());
+}
+
+Uint64 HashUTF8(const char* text, size_t size) {
+    Uint64 h = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= static_cast<unsigned char>(text[i]);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+SDL_Texture* RenderText(TextCache& cache, TTF_Font* font, const string& text, SDL_Color color, int* w, int* h) {
+    return cache.Get(font, text, color, w, h);
+}
+
+void RenderRoundedRect(ShapeBatch& shapes, SDL_Rect rect, SDL_Color color, int radius) {
+    shapes.AddRoundedRect(rect, color, radius);
+}
+
+void DrawCursor(ShapeBatch& shapes, int x, int y, int h, Uint32 ticks) {
+    if ((ticks / cursorBlinkMs) % 2 == 0) {
+        shapes.AddRect({ x, y, 1, h + 1 }, SDL_Color{ 230, 230, 230, 255 });
+    }
+}
@@ -0,0 +1,592 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "TextRasterizer.h"
+#include "Trace.h"
+#include "Utf8.h"
+
+// Render work issued since the last reset. Uploads are pixel transfers into
+// textures.
+struct RenderCounters {
+    Uint32 copyCalls = 0;
+    Uint32 geometryCalls = 0;
+    Uint32 textureUploads = 0;
+    Uint32 textureCreations = 0;
+
+    Uint32 DrawCalls() const {
+        return copyCalls + geometryCalls;
+    }
+};
+
+extern RenderCounters renderCounters;
+
+SDL_Texture* CreateTextTexture(SDL_Renderer* renderer, TTF_Font* font, const std::string& text, SDL_Color color);
+
+Uint64 HashUTF8(const std::string& text);
+Uint64 HashUTF8(const char* text, size_t size);
+
+struct TextCacheStats {
+    Uint64 hits = 0;
+    Uint64 misses = 0;
+    Uint64 evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+};
+
+// Bounded LRU of whole-string textures keyed by (content hash, color, font).
+// Returned textures stay owned by the cache; copies queued with Draw() are
+// issued by Flush(), and evicted textures are only destroyed after that.
+// With a rasterizer attached, a miss on one of its fonts queues the string
+// and returns null until Collect() uploads the finished surface.
+class TextCache {
+public:
+    TextCache(SDL_Renderer* renderer, size_t budgetBytes)
+        : renderer(renderer), budgetBytes(budgetBytes) {
+    }
+
+    ~TextCache() {
+        Release();
+    }
+
+    TextCache(const TextCache&) = delete;
+    TextCache& operator=(const TextCache&) = delete;
+
+    SDL_Texture* Get(TTF_Font* font, const std::string& text, SDL_Color color, int* w, int* h) {
+        Key key = { HashUTF8(text), PackColor(color), font };
+        auto it = index.find(key);
+        if (it != index.end()) {
+            entries.splice(entries.begin(), entries, it->second);
+            stats.hits++;
+            if (w) *w = it->second->w;
+            if (h) *h = it->second->h;
+            return it->second->texture;
+        }
+
+        if (rasterizer && rasterizer->Handles(font)) {
+            if (inflight.insert(key).second) {
+                stats.misses++;
+                rasterizer->Submit({ font, text, color });
+            }
+            return nullptr;
+        }
+
+        stats.misses++;
+        SDL_Texture* texture = CreateTextTexture(renderer, font, text, color);
+        if (!texture) return nullptr;
+
+        const Entry& entry = Insert(key, texture);
+        if (w) *w = entry.w;
+        if (h) *h = entry.h;
+        return texture;
+    }
+
+    void SetRasterizer(TextRasterizer* textRasterizer) {
+        rasterizer = textRasterizer;
+    }
+
+    // Uploads the strings the rasterizer finished since the last call.
+    // Returns true when any arrived, i.e. the frame should be redrawn.
+    bool Collect() {
+        if (!rasterizer || !rasterizer->Poll(finished)) return false;
+        for (TextJobResult& result : finished) {
+            Key key = { HashUTF8(result.text), PackColor(result.color), result.font };
+            inflight.erase(key);
+            if (!result.surface) continue;
+            SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, result.surface);
+            SDL_FreeSurface(result.surface);
+            if (!texture) continue;
+            renderCounters.textureCreations++;
+            renderCounters.textureUploads++;
+            if (index.count(key)) retired.push_back(texture);
+            else Insert(key, texture);
+        }
+        finished.clear();
+        return true;
+    }
+
+    void Draw(SDL_Texture* texture, const SDL_Rect& dst) {
+        pending.push_back({ texture, dst });
+    }
+
+    void Flush() {
+        for (const PendingCopy& copy : pending) {
+            SDL_RenderCopy(renderer, copy.texture, nullptr, &copy.dst);
+        }
+        renderCounters.copyCalls += Uint32(pending.size());
+        pending.clear();
+        for (SDL_Texture* texture : retired) {
+            SDL_DestroyTexture(texture);
+        }
+        retired.clear();
+    }
+
+    void SetBudget(size_t bytes) {
+        budgetBytes = bytes;
+        Trim();
+    }
+
+    const TextCacheStats& Stats() const {
+        return stats;
+    }
+
+    void Release() {
+        pending.clear();
+        Flush();
+        for (Entry& entry : entries) {
+            SDL_DestroyTexture(entry.texture);
+        }
+        entries.clear();
+        index.clear();
+        inflight.clear();
+        stats.entries = 0;
+        stats.bytes = 0;
+    }
+
+private:
+    struct Key {
+        Uint64 hash;
+        Uint32 color;
+        TTF_Font* font;
+
+        bool operator==(const Key& other) const {
+            return hash == other.hash && color == other.color && font == other.font;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            size_t h = size_t(key.hash);
+            h ^= std::hash<Uint32>()(key.color) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            h ^= std::hash<const void*>()(key.font) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            return h;
+        }
+    };
+
+    struct Entry {
+        Key key;
+        SDL_Texture* texture;
+        int w;
+        int h;
+        size_t bytes;
+    };
+
+    struct PendingCopy {
+        SDL_Texture* texture;
+        SDL_Rect dst;
+    };
+
+    static Uint32 PackColor(SDL_Color c) {
+        return (Uint32(c.r) << 24) | (Uint32(c.g) << 16) | (Uint32(c.b) << 8) | c.a;
+    }
+
+    const Entry& Insert(const Key& key, SDL_Texture* texture) {
+        Entry entry = { key, texture, 0, 0, 0 };
+        SDL_QueryTexture(texture, nullptr, nullptr, &entry.w, &entry.h);
+        entry.bytes = size_t(entry.w) * entry.h * 4;
+        entries.push_front(entry);
+        index[key] = entries.begin();
+        stats.bytes += entry.bytes;
+        stats.entries = entries.size();
+        Trim();
+        return entries.front();
+    }
+
+    void Trim() {
+        // The most recently inserted entry is never evicted, even if it alone exceeds the budget.
+        while (stats.bytes > budgetBytes && entries.size() > 1) {
+            Entry& victim = entries.back();
+            retired.push_back(victim.texture);
+            stats.bytes -= victim.bytes;
+            stats.evictions++;
+            index.erase(victim.key);
+            entries.pop_back();
+        }
+        stats.entries = entries.size();
+    }
+
+    SDL_Renderer* renderer;
+    size_t budgetBytes;
+    std::list<Entry> entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+    std::vector<PendingCopy> pending;
+    std::vector<SDL_Texture*> retired;
+    TextCacheStats stats;
+    TextRasterizer* rasterizer = nullptr;
+    std::unordered_set<Key, KeyHash> inflight;
+    std::vector<TextJobResult> finished;
+};
+
+SDL_Texture* RenderText(TextCache& cache, TTF_Font* font, const std::string& text, SDL_Color color, int* w, int* h);
+
+struct GlyphKey {
+    TTF_Font* font;
+    int size;
+    Uint32 codepoint;
+
+    bool operator==(const GlyphKey& other) const {
+        return font == other.font && size == other.size && codepoint == other.codepoint;
+    }
+};
+
+struct GlyphKeyHash {
+    size_t operator()(const GlyphKey& key) const {
+        size_t h = std::hash<const void*>()(key.font);
+        h ^= std::hash<Uint32>()(key.codepoint) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        h ^= std::hash<int>()(key.size) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+struct Glyph {
+    int page;
+    SDL_Rect src;
+    int offsetX;
+    int advance;
+};
+
+struct AtlasPage {
+    SDL_Texture* texture = nullptr;
+    int shelfX = 0;
+    int shelfY = 0;
+    int shelfHeight = 0;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+};
+
+// Glyphs are rasterized once per (font, size, codepoint) into a few large
+// streaming textures and strings are queued as textured quads. Flush() submits
+// one SDL_RenderGeometry call per page that has pending quads.
+class GlyphAtlas {
+public:
+    GlyphAtlas(SDL_Renderer* renderer, int pageSize = 1024, int maxPages = 4)
+        : renderer(renderer), pageSize(pageSize), maxPages(maxPages) {
+    }
+
+    ~GlyphAtlas() {
+        Release();
+    }
+
+    GlyphAtlas(const GlyphAtlas&) = delete;
+    GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+    size_t GlyphCount() const {
+        return glyphs.size();
+    }
+
+    int PageCount() const {
+        return int(pages.size());
+    }
+
+    int MeasureText(TTF_Font* font, const std::string& text) {
+        return MeasureText(font, text.data(), text.size());
+    }
+
+    int MeasureText(TTF_Font* font, const char* text, size_t size) {
+        int penX = 0;
+        Uint32 prev = 0;
+        const char* p = text;
+        const char* end = p + size;
+        while (p < end) {
+            Uint32 cp = DecodeUTF8(p, end);
+            const Glyph* glyph = GetGlyph(font, cp);
+            if (!glyph) continue;
+            if (prev && TTF_GetFontKerning(font)) penX += TTF_GetFontKerningSizeGlyphs32(font, prev, cp);
+            penX += glyph->advance;
+            prev = cp;
+        }
+        return penX;
+    }
+
+    // Pen advance of cp following prev (0 at the start of a run),
+    // including kerning; the same steps MeasureText adds up.
+    int Advance(TTF_Font* font, Uint32 prev, Uint32 cp) {
+        const Glyph* glyph = GetGlyph(font, cp);
+        if (!glyph) return 0;
+        int kerning = prev && TTF_GetFontKerning(font) ? TTF_GetFontKerningSizeGlyphs32(font, prev, cp) : 0;
+        return kerning + glyph->advance;
+    }
+
+    int DrawText(TTF_Font* font, const std::string& text, SDL_Color color, int x, int y, int maxWidth = -1) {
+        return DrawText(font, text.data(), text.size(), color, x, y, maxWidth);
+    }
+
+    int DrawText(TTF_Font* font, const char* text, size_t size, SDL_Color color, int x, int y, int maxWidth = -1) {
+        int penX = 0;
+        Uint32 prev = 0;
+        const char* p = text;
+        const char* end = p + size;
+        while (p < end) {
+            Uint32 cp = DecodeUTF8(p, end);
+            const Glyph* glyph = GetGlyph(font, cp);
+            if (!glyph) continue;
+            if (prev && TTF_GetFontKerning(font)) penX += TTF_GetFontKerningSizeGlyphs32(font, prev, cp);
+            if (maxWidth >= 0 && penX + glyph->offsetX + glyph->src.w > maxWidth) break;
+            if (glyph->src.w > 0) {
+                SDL_Rect dst = { x + penX + glyph->offsetX, y, glyph->src.w, glyph->src.h };
+                AddQuad(pages[glyph->page], glyph->src, dst, color);
+            }
+            penX += glyph->advance;
+            prev = cp;
+        }
+        return penX;
+    }
+
+    // Evicts every glyph if the atlas ran out of room during the last
+    // frame. Nothing is queued yet, so no quad still uses the old rects.
+    void BeginFrame() {
+        if (!resetPending) return;
+        resetPending = false;
+        glyphs.clear();
+        for (AtlasPage& page : pages) {
+            page.shelfX = 0;
+            page.shelfY = 0;
+            page.shelfHeight = 0;
+        }
+    }
+
+    void Flush() {
+        for (AtlasPage& page : pages) {
+            if (page.indices.empty()) continue;
+            SDL_RenderGeometry(renderer, page.texture,
+                page.vertices.data(), int(page.vertices.size()),
+                page.indices.data(), int(page.indices.size()));
+            renderCounters.geometryCalls++;
+            page.vertices.clear();
+            page.indices.clear();
+        }
+    }
+
+    void Release() {
+        for (AtlasPage& page : pages) {
+            SDL_DestroyTexture(page.texture);
+        }
+        pages.clear();
+        glyphs.clear();
+    }
+
+private:
+    const Glyph* GetGlyph(TTF_Font* font, Uint32 codepoint) {
+        GlyphKey key = { font, TTF_FontHeight(font), codepoint };
+        auto it = glyphs.find(key);
+        if (it != glyphs.end()) return &it->second;
+
+        int minx, maxx, miny, maxy, advance;
+        if (TTF_GlyphMetrics32(font, codepoint, &minx, &maxx, &miny, &maxy, &advance) != 0) {
+            if (codepoint == '?') return nullptr;
+            const Glyph* fallback = GetGlyph(font, codepoint == 0xFFFD ? '?' : 0xFFFD);
+            if (!fallback || fallback == &dropped) return fallback;
+            return &glyphs.emplace(key, *fallback).first->second;
+        }
+
+        // While the atlas is full, new glyphs keep their advance but are
+        // not drawn until BeginFrame makes room.
+        Glyph glyph = { 0, { 0, 0, 0, 0 }, std::min(0, minx), advance };
+        if (resetPending) {
+            dropped = glyph;
+            return &dropped;
+        }
+        TraceZone zone("Rasterize glyph");
+        SDL_Surface* surface = TTF_RenderGlyph32_Blended(font, codepoint, SDL_Color{ 255, 255, 255, 255 });
+        if (surface && surface->w > 0 && surface->h > 0) {
+            SDL_Surface* argb = surface;
+            if (surface->format->format != SDL_PIXELFORMAT_ARGB8888) {
+                argb = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+            }
+            if (argb && Allocate(argb->w, argb->h, glyph.page, glyph.src)) {
+                SDL_UpdateTexture(pages[glyph.page].texture, &glyph.src, argb->pixels, argb->pitch);
+                renderCounters.textureUploads++;
+            }
+            if (argb && argb != surface) SDL_FreeSurface(argb);
+        }
+        SDL_FreeSurface(surface);
+        if (resetPending) {
+            dropped = { 0, { 0, 0, 0, 0 }, glyph.offsetX, glyph.advance };
+            return &dropped;
+        }
+
+        return &glyphs.emplace(key, glyph).first->second;
+    }
+
+    bool Allocate(int w, int h, int& pageIndex, SDL_Rect& rect) {
+        if (w + 1 > pageSize || h + 1 > pageSize) return false;
+        for (size_t i = 0; i < pages.size(); ++i) {
+            if (Place(pages[i], w, h, rect)) {
+                pageIndex = int(i);
+                return true;
+            }
+        }
+        if (int(pages.size()) < maxPages && AddPage()) {
+            pageIndex = int(pages.size()) - 1;
+            return Place(pages.back(), w, h, rect);
+        }
+        // Evicting now would hand out rects that quads queued this frame
+        // still sample, so the eviction waits for the next frame.
+        resetPending = true;
+        return false;
+    }
+
+    bool Place(AtlasPage& page, int w, int h, SDL_Rect& rect) {
+        if (page.shelfX + w + 1 > pageSize) {
+            page.shelfY += page.shelfHeight;
+            page.shelfX = 0;
+            page.shelfHeight = 0;
+        }
+        if (page.shelfY + h + 1 > pageSize) return false;
+        rect = { page.shelfX, page.shelfY, w, h };
+        page.shelfX += w + 1;
+        page.shelfHeight = std::max(page.shelfHeight, h + 1);
+        return true;
+    }
+
+    bool AddPage() {
+        SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+            SDL_TEXTUREACCESS_STREAMING, pageSize, pageSize);
+        if (!texture) {
+            std::cerr << "Glyph atlas texture error: " << SDL_GetError() << std::endl;
+            return false;
+        }
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        void* pixels;
+        int pitch;
+        if (SDL_LockTexture(texture, nullptr, &pixels, &pitch) == 0) {
+            memset(pixels, 0, size_t(pitch) * pageSize);
+            SDL_UnlockTexture(texture);
+            renderCounters.textureUploads++;
+        }
+        renderCounters.textureCreations++;
+        AtlasPage page;
+        page.texture = texture;
+        pages.push_back(std::move(page));
+        return true;
+    }
+
+    void AddQuad(AtlasPage& page, const SDL_Rect& src, const SDL_Rect& dst, SDL_Color color) {
+        float inv = 1.0f / pageSize;
+        float u0 = src.x * inv, v0 = src.y * inv;
+        float u1 = (src.x + src.w) * inv, v1 = (src.y + src.h) * inv;
+        float x0 = float(dst.x), y0 = float(dst.y);
+        float x1 = float(dst.x + dst.w), y1 = float(dst.y + dst.h);
+        int base = int(page.vertices.size());
+        page.vertices.push_back({ { x0, y0 }, color, { u0, v0 } });
+        page.vertices.push_back({ { x1, y0 }, color, { u1, v0 } });
+        page.vertices.push_back({ { x1, y1 }, color, { u1, v1 } });
+        page.vertices.push_back({ { x0, y1 }, color, { u0, v1 } });
+        int quad[6] = { base, base + 1, base + 2, base, base + 2, base + 3 };
+        page.indices.insert(page.indices.end(), quad, quad + 6);
+    }
+
+    SDL_Renderer* renderer;
+    int pageSize;
+    int maxPages;
+    std::vector<AtlasPage> pages;
+    std::unordered_map<GlyphKey, Glyph, GlyphKeyHash> glyphs;
+    bool resetPending = false;
+    Glyph dropped = {};
+};
+
+// Collects untextured triangles for a whole frame so that every box, border
+// and cursor is submitted with a single SDL_RenderGeometry call.
+class ShapeBatch {
+public:
+    void AddRect(const SDL_Rect& rect, SDL_Color color) {
+        if (rect.w <= 0 || rect.h <= 0) return;
+        int base = int(vertices.size());
+        AddVertex(float(rect.x), float(rect.y), color);
+        AddVertex(float(rect.x + rect.w), float(rect.y), color);
+        AddVertex(float(rect.x + rect.w), float(rect.y + rect.h), color);
+        AddVertex(float(rect.x), float(rect.y + rect.h), color);
+        int quad[6] = { base, base + 1, base + 2, base, base + 2, base + 3 };
+        indices.insert(indices.end(), quad, quad + 6);
+    }
+
+    void AddRectOutline(const SDL_Rect& rect, SDL_Color color, int thickness = 1) {
+        AddRect({ rect.x, rect.y, rect.w, thickness }, color);
+        AddRect({ rect.x, rect.y + rect.h - thickness, rect.w, thickness }, color);
+        AddRect({ rect.x, rect.y + thickness, thickness, rect.h - 2 * thickness }, color);
+        AddRect({ rect.x + rect.w - thickness, rect.y + thickness, thickness, rect.h - 2 * thickness }, color);
+    }
+
+    void AddRoundedRect(const SDL_Rect& rect, SDL_Color color, int radius) {
+        radius = std::min(radius, std::min(rect.w, rect.h) / 2);
+        if (radius <= 0) {
+            AddRect(rect, color);
+            return;
+        }
+
+        const std::vector<SDL_FPoint>& arc = UnitArc(std::min(16, std::max(2, radius / 2)));
+        float r = float(radius);
+        float left = rect.x + r, right = rect.x + rect.w - r;
+        float top = rect.y + r, bottom = rect.y + rect.h - r;
+        const SDL_FPoint centers[4] = { { right, top }, { left, top }, { left, bottom }, { right, bottom } };
+        const float signs[4][2] = { { 1.f, -1.f }, { -1.f, -1.f }, { -1.f, 1.f }, { 1.f, 1.f } };
+
+        int center = int(vertices.size());
+        AddVertex(rect.x + rect.w * 0.5f, rect.y + rect.h * 0.5f, color);
+        int first = center + 1;
+        for (int corner = 0; corner < 4; ++corner) {
+            for (size_t i = 0; i < arc.size(); ++i) {
+                // Corners 1 and 3 walk the quarter arc backwards to keep the outline in order.
+                const SDL_FPoint& p = (corner % 2 == 0) ? arc[i] : arc[arc.size() - 1 - i];
+                AddVertex(centers[corner].x + signs[corner][0] * p.x * r,
+                    centers[corner].y + signs[corner][1] * p.y * r, color);
+            }
+        }
+        int last = int(vertices.size()) - 1;
+        for (int v = first; v < last; ++v) {
+            int tri[3] = { center, v, v + 1 };
+            indices.insert(indices.end(), tri, tri + 3);
+        }
+        int closing[3] = { center, last, first };
+        indices.insert(indices.end(), closing, closing + 3);
+    }
+
+    void Flush(SDL_Renderer* renderer) {
+        if (indices.empty()) return;
+        SDL_RenderGeometry(renderer, nullptr,
+            vertices.data(), int(vertices.size()),
+            indices.data(), int(indices.size()));
+        renderCounters.geometryCalls++;
+        vertices.clear();
+        indices.clear();
+    }
+
+private:
+    void AddVertex(float x, float y, SDL_Color color) {
+        vertices.push_back({ { x, y }, color, { 0.f, 0.f } });
+    }
+
+    const std::vector<SDL_FPoint>& UnitArc(int segments) {
+        if (int(arcs.size()) <= segments) arcs.resize(segments + 1);
+        std::vector<SDL_FPoint>& arc = arcs[segments];
+        if (arc.empty()) {
+            for (int i = 0; i <= segments; ++i) {
+                float angle = 1.5707963f * i / segments;
+                arc.push_back({ std::cos(angle), std::sin(angle) });
+            }
+        }
+        return arc;
+    }
+
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+    std::vector<std::vector<SDL_FPoint>> arcs;
+};
+
+void RenderRoundedRect(ShapeBatch& shapes, SDL_Rect rect, SDL_Color color, int radius);
+
+const Uint32 cursorBlinkMs = 500;
+const Uint32 pulsePeriodMs = 2000;
+const Uint32 pulseStepMs = 50;
+
+void DrawCursor(ShapeBatch& shapes, int x, int y, int h, Uint32 ticks);
@@ -0,0 +1,218 @@
+﻿#include "Search.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "Trace.h"
+#include "Utf8.h"
+
+using namespace std;
+
+Uint32 FoldCase(Uint32 codepoint) {
+    if (codepoint >= 'A' && codepoint <= 'Z') return codepoint + 32;
+    if (codepoint >= 0xC0 && codepoint <= 0xDE && codepoint != 0xD7) return codepoint + 32;
+    if (codepoint >= 0x410 && codepoint <= 0x42F) return codepoint + 32;
+    if (codepoint >= 0x400 && codepoint <= 0x40F) return codepoint + 80;
+    return codepoint;
+}
+
+int CompareFolded(TextRef a, TextRef b) {
+    const char* p = a.data;
+    const char* pEnd = a.data + a.size;
+    const char* q = b.data;
+    const char* qEnd = b.data + b.size;
+    while (p < pEnd && q < qEnd) {
+        Uint32 x = FoldCase(DecodeUTF8(p, pEnd));
+        Uint32 y = FoldCase(DecodeUTF8(q, qEnd));
+        if (x != y) return x < y ? -1 : 1;
+    }
+    return (p < pEnd) - (q < qEnd);
+}
+
+static bool IsWordChar(Uint32 codepoint) {
+    if (codepoint < 0x80) return isalnum(int(codepoint)) != 0;
+    return codepoint >= 0xC0;
+}
+
+static void FoldText(const char* text, size_t size, vector<Uint32>& out) {
+    out.clear();
+    const char* p = text;
+    const char* end = text + size;
+    while (p < end) out.push_back(FoldCase(DecodeUTF8(p, end)));
+}
+
+// Codepoints need 21 bits, so up to three fit in one key. Text never holds
+// U+0000, which keeps one- and two-character keys distinct from trigrams.
+static Uint64 GramKey(const Uint32* codepoints, size_t count) {
+    Uint64 key = Uint64(codepoints[0]) << 42;
+    if (count > 1) key |= Uint64(codepoints[1]) << 21;
+    if (count > 2) key |= codepoints[2];
+    return key;
+}
+
+void SearchIndex::CollectKeys(TextRef text) {
+    FoldText(text.data, text.size, scratchText);
+    scratchKeys.clear();
+    size_t n = scratchText.size();
+    for (size_t i = 0; i < n; ++i) {
+        const Uint32* at = &scratchText[i];
+        if (i + 2 < n) scratchKeys.push_back(GramKey(at, 3));
+        if (IsWordChar(at[0]) && (i == 0 || !IsWordChar(at[-1]))) {
+            scratchKeys.push_back(GramKey(at, 1));
+            if (i + 1 < n && IsWordChar(at[1])) scratchKeys.push_back(GramKey(at, 2));
+        }
+    }
+    sort(scratchKeys.begin(), scratchKeys.end());
+    scratchKeys.erase(unique(scratchKeys.begin(), scratchKeys.end()), scratchKeys.end());
+}
+
+void SearchIndex::Build(const Inventory& inventory) {
+    TraceZone zone("Search build");
+    postings.clear();
+    for (size_t slot = 0; slot < inventory.Size(); ++slot) {
+        Uint64 posting = Uint64(inventory.IdAt(slot)) * 2;
+        CollectKeys(inventory.Name(slot));
+        for (Uint64 key : scratchKeys) postings[key].push_back(posting);
+        CollectKeys(inventory.Description(slot));
+        for (Uint64 key : scratchKeys) postings[key].push_back(posting + 1);
+    }
+    for (auto& list : postings) sort(list.second.begin(), list.second.end());
+    built = true;
+    lastRevision = ~0ULL;
+}
+
+void SearchIndex::AddField(Uint64 posting, TextRef text) {
+    CollectKeys(text);
+    for (Uint64 key : scratchKeys) {
+        vector<Uint64>& list = postings[key];
+        if (list.empty() || list.back() < posting) {
+            list.push_back(posting);
+            continue;
+        }
+        auto it = lower_bound(list.begin(), list.end(), posting);
+        if (*it != posting) list.insert(it, posting);
+    }
+}
+
+void SearchIndex::RemoveField(Uint64 posting, TextRef text) {
+    CollectKeys(text);
+    for (Uint64 key : scratchKeys) {
+        auto found = postings.find(key);
+        if (found == postings.end()) continue;
+        vector<Uint64>& list = found->second;
+        auto it = lower_bound(list.begin(), list.end(), posting);
+        if (it != list.end() && *it == posting) list.erase(it);
+        if (list.empty()) postings.erase(found);
+    }
+}
+
+void SearchIndex::Add(ToyId id, TextRef name, TextRef description) {
+    if (!built) return;
+    AddField(Uint64(id) * 2, name);
+    AddField(Uint64(id) * 2 + 1, description);
+    lastRevision = ~0ULL;
+}
+
+void SearchIndex::Remove(ToyId id, TextRef name, TextRef description) {
+    if (!built) return;
+    RemoveField(Uint64(id) * 2, name);
+    RemoveField(Uint64(id) * 2 + 1, description);
+    lastRevision = ~0ULL;
+}
+
+// 0: the text starts with the query, 1: a word does, 2: anywhere else,
+// -1: no match.
+int SearchIndex::MatchTier(TextRef text, const vector<Uint32>& query, bool wordStartOnly) {
+    FoldText(text.data, text.size, scratchText);
+    int best = -1;
+    auto it = scratchText.begin();
+    while (best != 0) {
+        it = search(it, scratchText.end(), query.begin(), query.end());
+        if (it == scratchText.end()) break;
+        int tier = it == scratchText.begin() ? 0 : !IsWordChar(it[-1]) ? 1 : 2;
+        if (!wordStartOnly || tier < 2) {
+            if (best < 0 || tier < best) best = tier;
+        }
+        ++it;
+    }
+    return best;
+}
+
+static void Intersect(vector<Uint64>& candidates, const vector<Uint64>& list) {
+    size_t kept = 0;
+    auto it = list.begin();
+    for (Uint64 posting : candidates) {
+        it = lower_bound(it, list.end(), posting);
+        if (it == list.end()) break;
+        if (*it == posting) candidates[kept++] = posting;
+    }
+    candidates.resize(kept);
+}
+
+void SearchIndex::Query(const string& query, const Inventory& inventory, vector<ToyId>& out) {
+    TraceZone zone("Search");
+    vector<Uint32> folded;
+    FoldText(query.data(), query.size(), folded);
+    out.clear();
+    if (folded.empty()) {
+        lastQuery.clear();
+        return;
+    }
+    if (!built) Build(inventory);
+
+    vector<Uint64> candidates;
+    bool refine = lastRevision == inventory.Revision() && lastQuery.size() >= 3 &&
+        search(folded.begin(), folded.end(), lastQuery.begin(), lastQuery.end()) != folded.end();
+    if (refine) {
+        for (ToyId id : lastResults) {
+            candidates.push_back(Uint64(id) * 2);
+            candidates.push_back(Uint64(id) * 2 + 1);
+        }
+    }
+    else if (folded.size() < 3) {
+        auto found = postings.find(GramKey(folded.data(), folded.size()));
+        if (found != postings.end()) candidates = found->second;
+    }
+    else {
+        vector<const vector<Uint64>*> lists;
+        for (size_t i = 0; i + 2 < folded.size(); ++i) {
+            auto found = postings.find(GramKey(&folded[i], 3));
+            if (found == postings.end()) {
+                lists.clear();
+                break;
+            }
+            lists.push_back(&found->second);
+        }
+        if (!lists.empty()) {
+            sort(lists.begin(), lists.end(), [](const vector<Uint64>* a, const vector<Uint64>* b) {
+                return a->size() < b->size();
+                });
+            candidates = *lists[0];
+            for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) Intersect(candidates, *lists[i]);
+        }
+    }
+
+    // Trigrams only prove the characters are there, not that they are
+    // adjacent, so every candidate is checked against its text.
+    vector<Uint64> ranked;
+    ToyId lastMatched = invalidToyId;
+    for (Uint64 posting : candidates) {
+        ToyId id = ToyId(posting / 2);
+        Uint32 field = Uint32(posting & 1);
+        if (field == 1 && id == lastMatched) continue;
+        int slot = inventory.SlotOf(id);
+        if (slot < 0) continue;
+        TextRef text = field == 0 ? inventory.Name(slot) : inventory.Description(slot);
+        int tier = MatchTier(text, folded, folded.size() < 3);
+        if (tier < 0) continue;
+        ranked.push_back(Uint64(field) << 62 | Uint64(tier) << 60 | Uint64(min<Uint32>(text.size, 0xFFFFFFF)) << 32 | id);
+        lastMatched = id;
+    }
+    sort(ranked.begin(), ranked.end());
+    out.reserve(ranked.size());
+    for (Uint64 score : ranked) out.push_back(ToyId(score & 0xFFFFFFFF));
+
+    lastQuery.swap(folded);
+    lastResults = out;
+    lastRevision = inventory.Revision();
+}
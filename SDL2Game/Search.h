@@ -0,0 +1,56 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Inventory.h"
+
+// Simple case folding for search: ASCII, Latin-1 and Cyrillic letters map
+// to lower case, everything else is returned unchanged.
+Uint32 FoldCase(Uint32 codepoint);
+
+// Codepoint-wise comparison of the folded texts; negative, zero or positive.
+int CompareFolded(TextRef a, TextRef b);
+
+// Inverted index from case-folded character trigrams to the toys whose name
+// or description contains them. Queries of three or more characters are
+// substring searches; shorter ones match the start of a word, which the
+// index covers with one- and two-character word prefixes.
+//
+// Postings hold id * 2 + field (0 for the name, 1 for the description) as
+// a Uint64, which fits every ToyId, in ascending order, so a match must
+// have every trigram in the same field, and both fields of a toy sit next
+// to each other.
+//
+// The index is built by the first query; until then Add and Remove have
+// nothing to keep current and do nothing.
+class SearchIndex {
+public:
+    void Build(const Inventory& inventory);
+
+    void Add(ToyId id, TextRef name, TextRef description);
+    void Remove(ToyId id, TextRef name, TextRef description);
+
+    // Matching ids, best first: name before description, then a match at
+    // the start of the text, then at the start of a word, then shorter
+    // texts. A query that extends the previous one on an unchanged
+    // inventory only re-checks the previous results.
+    void Query(const std::string& query, const Inventory& inventory, std::vector<ToyId>& out);
+
+private:
+    void CollectKeys(TextRef text);
+    void AddField(Uint64 posting, TextRef text);
+    void RemoveField(Uint64 posting, TextRef text);
+    int MatchTier(TextRef text, const std::vector<Uint32>& query, bool wordStartOnly);
+
+    bool built = false;
+    std::unordered_map<Uint64, std::vector<Uint64>> postings;
+    std::vector<Uint32> scratchText;
+    std::vector<Uint64> scratchKeys;
+
+    std::vector<Uint32> lastQuery;
+    std::vector<ToyId> lastResults;
+    Uint64 lastRevision = ~0ULL;
+};
@@ -0,0 +1,23 @@
+﻿#include "Storage.h"
+
+#include <cstdio>
+
+using namespace std;
+
+bool ReplaceFileAtomic(const string& from, const string& to) {
+#ifdef _WIN32
+    if (MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) return true;
+    // A target that is still mapped cannot be replaced, but it can be renamed
+    // aside (it was opened with FILE_SHARE_DELETE) and deleted once unmapped.
+    string aside = to + ".old." + to_string(GetTickCount());
+    if (!MoveFileExA(to.c_str(), aside.c_str(), MOVEFILE_WRITE_THROUGH)) return false;
+    if (!MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_WRITE_THROUGH)) {
+        MoveFileExA(aside.c_str(), to.c_str(), MOVEFILE_WRITE_THROUGH);
+        return false;
+    }
+    DeleteFileA(aside.c_str());
+    return true;
+#else
+    return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
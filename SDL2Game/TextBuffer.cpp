@@ -0,0 +1,229 @@
+﻿#include "TextBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+const size_t minGapBytes = 64;
+const size_t maxTextUndo = 200;
+
+void TextBuffer::Assign(const string& text) {
+    buffer.assign(text.begin(), text.end());
+    gapStart = buffer.size();
+    buffer.resize(buffer.size() + minGapBytes);
+    gapEnd = buffer.size();
+    cursor = anchor = text.size();
+    size_t count = 0;
+    for (size_t i = 0; i < text.size(); ++i) count += (static_cast<unsigned char>(text[i]) & 0xC0) != 0x80;
+    advances.assign(count, -1);
+    unmeasured = true;
+    undoStack.clear();
+    redoStack.clear();
+    flat = text;
+    flatStale = false;
+}
+
+const string& TextBuffer::Text() const {
+    if (flatStale) {
+        flat.assign(buffer.begin(), buffer.begin() + gapStart);
+        flat.append(buffer.begin() + gapEnd, buffer.end());
+        flatStale = false;
+    }
+    return flat;
+}
+
+string TextBuffer::Selected() const {
+    string text;
+    for (size_t i = SelectionStart(); i < SelectionEnd(); ++i) text.push_back(At(i));
+    return text;
+}
+
+size_t TextBuffer::PrevBoundary(size_t offset) const {
+    if (offset == 0) return 0;
+    --offset;
+    while (offset > 0 && IsContinuation(offset)) --offset;
+    return offset;
+}
+
+size_t TextBuffer::NextBoundary(size_t offset) const {
+    size_t size = Size();
+    if (offset >= size) return size;
+    ++offset;
+    while (offset < size && IsContinuation(offset)) ++offset;
+    return offset;
+}
+
+size_t TextBuffer::CodepointIndex(size_t offset) const {
+    size_t index = 0;
+    for (size_t i = 0; i < offset; ++i) index += !IsContinuation(i);
+    return index;
+}
+
+void TextBuffer::MoveTo(size_t offset, bool select) {
+    cursor = min(offset, Size());
+    if (!select) anchor = cursor;
+}
+
+void TextBuffer::MoveLeft(bool select, bool word) {
+    if (HasSelection() && !select) {
+        MoveTo(SelectionStart(), false);
+        return;
+    }
+    size_t offset = PrevBoundary(cursor);
+    if (word) {
+        while (offset > 0 && At(offset) == ' ') offset = PrevBoundary(offset);
+        while (offset > 0 && At(PrevBoundary(offset)) != ' ') offset = PrevBoundary(offset);
+    }
+    MoveTo(offset, select);
+}
+
+void TextBuffer::MoveRight(bool select, bool word) {
+    if (HasSelection() && !select) {
+        MoveTo(SelectionEnd(), false);
+        return;
+    }
+    size_t size = Size();
+    size_t offset = NextBoundary(cursor);
+    if (word) {
+        while (offset < size && At(offset) != ' ') offset = NextBoundary(offset);
+        while (offset < size && At(offset) == ' ') offset = NextBoundary(offset);
+    }
+    MoveTo(offset, select);
+}
+
+void TextBuffer::SelectAll() {
+    anchor = 0;
+    cursor = Size();
+}
+
+void TextBuffer::Insert(const char* text, size_t size) {
+    Replace(SelectionStart(), SelectionEnd(), text, size);
+}
+
+void TextBuffer::Backspace() {
+    if (HasSelection()) Replace(SelectionStart(), SelectionEnd(), nullptr, 0);
+    else if (cursor > 0) Replace(PrevBoundary(cursor), cursor, nullptr, 0);
+}
+
+void TextBuffer::DeleteForward() {
+    if (HasSelection()) Replace(SelectionStart(), SelectionEnd(), nullptr, 0);
+    else if (cursor < Size()) Replace(cursor, NextBoundary(cursor), nullptr, 0);
+}
+
+bool TextBuffer::Undo() {
+    if (undoStack.empty()) return false;
+    EditRecord edit = move(undoStack.back());
+    undoStack.pop_back();
+    Replace(edit.offset, edit.offset + edit.inserted.size(), edit.removed.data(), edit.removed.size(), false);
+    cursor = edit.cursor;
+    anchor = edit.anchor;
+    redoStack.push_back(move(edit));
+    return true;
+}
+
+bool TextBuffer::Redo() {
+    if (redoStack.empty()) return false;
+    EditRecord edit = move(redoStack.back());
+    redoStack.pop_back();
+    Replace(edit.offset, edit.offset + edit.removed.size(), edit.inserted.data(), edit.inserted.size(), false);
+    undoStack.push_back(move(edit));
+    return true;
+}
+
+// Typing extends the last record until a space follows a word; Backspace
+// and Delete extend it while they keep eating at the same spot.
+void TextBuffer::Record(size_t start, size_t end, const char* text, size_t size) {
+    redoStack.clear();
+    string removed;
+    for (size_t i = start; i < end; ++i) removed.push_back(At(i));
+
+    if (!undoStack.empty()) {
+        EditRecord& last = undoStack.back();
+        bool typing = removed.empty() && size > 0 && !last.inserted.empty() &&
+            last.offset + last.inserted.size() == start && !(text[0] == ' ' && last.inserted.back() != ' ');
+        bool erasing = size == 0 && !removed.empty() && last.inserted.empty();
+        if (typing) {
+            last.inserted.append(text, size);
+            return;
+        }
+        if (erasing && end == last.offset) {
+            last.removed.insert(0, removed);
+            last.offset = start;
+            return;
+        }
+        if (erasing && start == last.offset) {
+            last.removed.append(removed);
+            return;
+        }
+    }
+    undoStack.push_back(EditRecord{ start, move(removed), size > 0 ? string(text, size) : string(), cursor, anchor });
+    if (undoStack.size() > maxTextUndo) undoStack.erase(undoStack.begin());
+}
+
+void TextBuffer::MoveGap(size_t offset) {
+    if (offset < gapStart) {
+        size_t count = gapStart - offset;
+        memmove(&buffer[gapEnd - count], &buffer[offset], count);
+        gapStart -= count;
+        gapEnd -= count;
+    }
+    else if (offset > gapStart) {
+        size_t count = offset - gapStart;
+        memmove(&buffer[gapStart], &buffer[gapEnd], count);
+        gapStart += count;
+        gapEnd += count;
+    }
+}
+
+void TextBuffer::Replace(size_t start, size_t end, const char* text, size_t size, bool record) {
+    if (start == end && size == 0) return;
+    if (record) Record(start, end, text, size);
+
+    size_t first = CodepointIndex(start);
+    size_t removed = CodepointIndex(end) - first;
+
+    MoveGap(start);
+    gapEnd += end - start;
+    if (gapEnd - gapStart < size) {
+        size_t tail = buffer.size() - gapEnd;
+        size_t grown = max(buffer.size() * 2, Size() + size + minGapBytes);
+        vector<char> next(grown);
+        memcpy(next.data(), buffer.data(), gapStart);
+        memcpy(next.data() + grown - tail, buffer.data() + gapEnd, tail);
+        buffer.swap(next);
+        gapEnd = grown - tail;
+    }
+    if (size > 0) memcpy(&buffer[gapStart], text, size);
+    gapStart += size;
+
+    size_t inserted = 0;
+    for (size_t i = 0; i < size; ++i) inserted += (static_cast<unsigned char>(text[i]) & 0xC0) != 0x80;
+    advances.erase(advances.begin() + first, advances.begin() + first + removed);
+    advances.insert(advances.begin() + first, inserted, -1);
+    if (first + inserted < advances.size()) advances[first + inserted] = -1;
+    unmeasured = true;
+    flatStale = true;
+
+    cursor = anchor = start + size;
+}
+
+int TextBuffer::XAt(size_t offset) const {
+    size_t index = min(CodepointIndex(min(offset, Size())), advances.size());
+    int x = 0;
+    for (size_t i = 0; i < index; ++i) x += max(0, advances[i]);
+    return x;
+}
+
+size_t TextBuffer::OffsetAtX(int x, bool roundUp) const {
+    size_t size = Size();
+    size_t offset = 0;
+    int penX = 0;
+    for (size_t i = 0; offset < size && i < advances.size(); ++i) {
+        int advance = max(0, advances[i]);
+        if (roundUp ? penX >= x : penX + advance / 2 > x) break;
+        penX += advance;
+        offset = NextBoundary(offset);
+    }
+    return offset;
+}
@@ -0,0 +1,130 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <string>
+#include <vector>
+
+#include "Utf8.h"
+
+// Editable UTF-8 text in a gap buffer: the gap sits at the last edit, so
+// typing or deleting in one place moves no bytes. Offsets count bytes of
+// the text without the gap and always fall on codepoint boundaries.
+//
+// Edits are kept as (offset, removed, inserted) records for undo; a run of
+// typing or deleting in one place is one record.
+//
+// The buffer also keeps the pixel advance of every codepoint. An edit only
+// marks the inserted codepoints and the one after them (whose kerning pair
+// changed) for measuring, so Measure() only asks for the changed run.
+class TextBuffer {
+public:
+    void Assign(const std::string& text);
+
+    // Contiguous copy for drawing and wrapping, rebuilt only after an edit;
+    // the gap itself never moves for a read.
+    const std::string& Text() const;
+
+    // Calls f(data, size) for the text before and after the gap. Both spans
+    // end on codepoint boundaries.
+    template <typename F>
+    void ForEachSpan(F&& f) const {
+        if (gapStart > 0) f(buffer.data(), gapStart);
+        if (gapEnd < buffer.size()) f(buffer.data() + gapEnd, buffer.size() - gapEnd);
+    }
+
+    size_t Size() const {
+        return buffer.size() - (gapEnd - gapStart);
+    }
+
+    size_t Cursor() const {
+        return cursor;
+    }
+
+    bool HasSelection() const {
+        return cursor != anchor;
+    }
+
+    size_t SelectionStart() const {
+        return cursor < anchor ? cursor : anchor;
+    }
+
+    size_t SelectionEnd() const {
+        return cursor < anchor ? anchor : cursor;
+    }
+
+    std::string Selected() const;
+
+    // With select, the anchor stays put and the selection grows or shrinks.
+    void MoveTo(size_t offset, bool select);
+    void MoveLeft(bool select, bool word);
+    void MoveRight(bool select, bool word);
+    void SelectAll();
+
+    // Replaces the selection, or inserts at the cursor.
+    void Insert(const char* text, size_t size);
+    void Backspace();
+    void DeleteForward();
+
+    bool Undo();
+    bool Redo();
+
+    // advance(prev, cp) returns the pen advance of cp after prev.
+    template <typename F>
+    void Measure(F&& advance) {
+        if (!unmeasured) return;
+        size_t i = 0;
+        Uint32 prev = 0;
+        ForEachSpan([&](const char* p, size_t size) {
+            const char* end = p + size;
+            while (p < end) {
+                Uint32 cp = DecodeUTF8(p, end);
+                if (advances[i] < 0) advances[i] = advance(prev, cp);
+                prev = cp;
+                ++i;
+            }
+            });
+        unmeasured = false;
+    }
+
+    // Pixel position of offset; valid after Measure().
+    int XAt(size_t offset) const;
+
+    // The boundary nearest to x, or with roundUp the first one at or after x.
+    size_t OffsetAtX(int x, bool roundUp = false) const;
+
+private:
+    char At(size_t offset) const {
+        return offset < gapStart ? buffer[offset] : buffer[offset + (gapEnd - gapStart)];
+    }
+
+    bool IsContinuation(size_t offset) const {
+        return (static_cast<unsigned char>(At(offset)) & 0xC0) == 0x80;
+    }
+
+    size_t PrevBoundary(size_t offset) const;
+    size_t NextBoundary(size_t offset) const;
+    size_t CodepointIndex(size_t offset) const;
+    struct EditRecord {
+        size_t offset;
+        std::string removed;
+        std::string inserted;
+        size_t cursor;
+        size_t anchor;
+    };
+
+    void MoveGap(size_t offset);
+    void Record(size_t start, size_t end, const char* text, size_t size);
+    void Replace(size_t start, size_t end, const char* text, size_t size, bool record = true);
+
+    std::vector<char> buffer;
+    size_t gapStart = 0;
+    size_t gapEnd = 0;
+    size_t cursor = 0;
+    size_t anchor = 0;
+    std::vector<int> advances;
+    bool unmeasured = false;
+    mutable std::string flat;
+    mutable bool flatStale = false;
+    std::vector<EditRecord> undoStack;
+    std::vector<EditRecord> redoStack;
+};
@@ -0,0 +1,115 @@
+﻿#include "TextRasterizer.h"
+
+#include <iostream>
+
+#include "Trace.h"
+
+using namespace std;
+
+void TextRasterizer::AddFont(TTF_Font* font, const FontManager& fonts, int size) {
+    sources.push_back({ font, &fonts, size });
+}
+
+bool TextRasterizer::Start(int workerCount) {
+    Stop();
+    for (int i = 0; i < workerCount; ++i) {
+        vector<TTF_Font*> fonts;
+        for (const FontSource& source : sources) {
+            TTF_Font* font = source.fonts->Open(source.size);
+            if (!font) {
+                cerr << "Text worker font error: " << TTF_GetError() << endl;
+                break;
+            }
+            fonts.push_back(font);
+        }
+        if (fonts.size() != sources.size()) {
+            for (TTF_Font* font : fonts) TTF_CloseFont(font);
+            break;
+        }
+        workerFonts.push_back(fonts);
+    }
+
+    // Finished jobs post this event so an idle main loop wakes up to
+    // upload them.
+    doneEvent = SDL_RegisterEvents(1);
+    stopping = false;
+    for (size_t i = 0; i < workerFonts.size(); ++i) {
+        workers.emplace_back(&TextRasterizer::Run, this, i);
+    }
+    return !workers.empty();
+}
+
+void TextRasterizer::Stop() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopping = true;
+        jobs.clear();
+    }
+    wake.notify_all();
+    for (thread& worker : workers) worker.join();
+    workers.clear();
+    for (auto& fonts : workerFonts) {
+        for (TTF_Font* font : fonts) TTF_CloseFont(font);
+    }
+    workerFonts.clear();
+    for (TextJobResult& result : results) {
+        if (result.surface) SDL_FreeSurface(result.surface);
+    }
+    results.clear();
+}
+
+bool TextRasterizer::Handles(TTF_Font* font) const {
+    if (workers.empty()) return false;
+    for (const FontSource& source : sources) {
+        if (source.font == font) return true;
+    }
+    return false;
+}
+
+void TextRasterizer::Submit(TextJob job) {
+    {
+        lock_guard<mutex> lock(mutex_);
+        jobs.push_back(move(job));
+    }
+    wake.notify_one();
+}
+
+bool TextRasterizer::Poll(vector<TextJobResult>& out) {
+    lock_guard<mutex> lock(mutex_);
+    if (results.empty()) return false;
+    out.swap(results);
+    results.clear();
+    return true;
+}
+
+void TextRasterizer::Run(size_t worker) {
+    tracer.SetThreadName("text");
+    unique_lock<mutex> lock(mutex_);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (stopping) break;
+        TextJob job = move(jobs.front());
+        jobs.pop_front();
+        lock.unlock();
+
+        TTF_Font* font = nullptr;
+        for (size_t i = 0; i < sources.size(); ++i) {
+            if (sources[i].font == job.font) font = workerFonts[worker][i];
+        }
+        SDL_Surface* surface = nullptr;
+        {
+            TraceZone zone("Rasterize text");
+            surface = font ? TTF_RenderUTF8_Blended(font, job.text.c_str(), job.color) : nullptr;
+        }
+
+        lock.lock();
+        bool first = results.empty();
+        results.push_back({ job.font, move(job.text), job.color, surface });
+        if (first && doneEvent != Uint32(-1)) {
+            SDL_Event event;
+            SDL_zero(event);
+            event.type = doneEvent;
+            SDL_PushEvent(&event);
+        }
+    }
+}
@@ -0,0 +1,70 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Fonts.h"
+
+struct TextJob {
+    TTF_Font* font;
+    std::string text;
+    SDL_Color color;
+};
+
+// surface is null when rasterization failed; otherwise the receiver owns it.
+struct TextJobResult {
+    TTF_Font* font;
+    std::string text;
+    SDL_Color color;
+    SDL_Surface* surface;
+};
+
+// Renders strings to surfaces on worker threads; only the texture upload
+// is left to the render thread. FreeType faces must not be shared between
+// threads, so every worker renders with its own handle of each registered
+// font, all opened on the thread that calls Start().
+class TextRasterizer {
+public:
+    ~TextRasterizer() {
+        Stop();
+    }
+
+    // font is the render thread's handle; jobs name it and workers
+    // substitute their own handle opened from fonts at size.
+    void AddFont(TTF_Font* font, const FontManager& fonts, int size);
+
+    bool Start(int workerCount);
+    void Stop();
+
+    bool Handles(TTF_Font* font) const;
+
+    void Submit(TextJob job);
+
+    // Takes every finished job; returns false when there were none.
+    bool Poll(std::vector<TextJobResult>& out);
+
+private:
+    struct FontSource {
+        TTF_Font* font;
+        const FontManager* fonts;
+        int size;
+    };
+
+    void Run(size_t worker);
+
+    std::vector<FontSource> sources;
+    std::vector<std::vector<TTF_Font*>> workerFonts;
+    std::vector<std::thread> workers;
+    std::mutex mutex_;
+    std::condition_variable wake;
+    std::deque<TextJob> jobs;
+    std::vector<TextJobResult> results;
+    bool stopping = false;
+    Uint32 doneEvent = 0;
+};
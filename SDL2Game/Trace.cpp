@@ -0,0 +1,104 @@
+﻿#include "Trace.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+Tracer tracer;
+
+static thread_local TraceRing* threadRing = nullptr;
+static thread_local const char* threadName = nullptr;
+
+void Tracer::Start() {
+    if (Enabled()) return;
+    lock_guard<mutex> lock(registryMutex);
+    // Zones still open at the last Stop() may have landed since.
+    for (auto& ring : rings) {
+        ring->Drain([](const TraceEvent&) {});
+        ring->dropped.store(0, memory_order_relaxed);
+    }
+    collected.clear();
+    overflow = 0;
+    origin = SDL_GetPerformanceCounter();
+    enabled.store(true, memory_order_relaxed);
+}
+
+void Tracer::Stop() {
+    if (!Enabled()) return;
+    enabled.store(false, memory_order_relaxed);
+    Collect();
+}
+
+void Tracer::SetThreadName(const char* name) {
+    threadName = name;
+    if (threadRing) threadRing->name.store(name, memory_order_relaxed);
+}
+
+TraceRing* Tracer::ThreadRing() {
+    if (!threadRing) {
+        lock_guard<mutex> lock(registryMutex);
+        rings.emplace_back(new TraceRing(int(rings.size()) + 1, threadName));
+        threadRing = rings.back().get();
+    }
+    return threadRing;
+}
+
+void Tracer::Record(const char* name, Uint64 start, Uint64 end) {
+    ThreadRing()->Push(TraceEvent{ name, start, end });
+}
+
+void Tracer::Collect() {
+    lock_guard<mutex> lock(registryMutex);
+    for (auto& ring : rings) {
+        int tid = ring->tid;
+        ring->Drain([&](const TraceEvent& event) {
+            if (event.start < origin) return;
+            if (collected.size() < maxTraceEvents) collected.emplace_back(tid, event);
+            else overflow++;
+            });
+    }
+}
+
+bool Tracer::Write(const string& path) {
+    Collect();
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) {
+        cerr << "Trace write error: " << path << endl;
+        return false;
+    }
+
+    lock_guard<mutex> lock(registryMutex);
+    double usPerTick = 1e6 / double(SDL_GetPerformanceFrequency());
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    for (auto& ring : rings) {
+        const char* name = ring->name.load(memory_order_relaxed);
+        if (!first) out << ",\n";
+        first = false;
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->tid
+            << ",\"args\":{\"name\":\"" << (name ? name : "worker") << "\"}}";
+    }
+    out << fixed << setprecision(3);
+    for (auto& item : collected) {
+        const TraceEvent& event = item.second;
+        if (!first) out << ",\n";
+        first = false;
+        out << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << item.first
+            << ",\"ts\":" << (event.start - origin) * usPerTick
+            << ",\"dur\":" << (event.end - event.start) * usPerTick << "}";
+    }
+    out << "\n]}\n";
+    out.close();
+    if (!out) {
+        cerr << "Trace write error: " << path << endl;
+        return false;
+    }
+    cout << "Trace: " << collected.size() << " events written to " << path;
+    Uint64 dropped = overflow;
+    for (auto& ring : rings) dropped += ring->dropped.load(memory_order_relaxed);
+    if (dropped > 0) cout << " (" << dropped << " dropped)";
+    cout << endl;
+    return true;
+}
@@ -0,0 +1,118 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One completed zone. Names are string literals, so events hold no heap
+// memory and can be copied between threads as plain data.
+struct TraceEvent {
+    const char* name;
+    Uint64 start;
+    Uint64 end;
+};
+
+const size_t traceRingCapacity = 1 << 14;
+const size_t maxTraceEvents = 1 << 20;
+
+// Single-producer / single-consumer ring owned by one thread. The producer
+// never blocks: when the consumer falls behind, new events are dropped and
+// counted.
+class TraceRing {
+public:
+    TraceRing(int tid, const char* name) : tid(tid), name(name), events(traceRingCapacity) {
+    }
+
+    void Push(const TraceEvent& event) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == traceRingCapacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events[head & (traceRingCapacity - 1)] = event;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    template <typename F>
+    void Drain(F&& consume) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            consume(events[tail & (traceRingCapacity - 1)]);
+        }
+        tail_.store(tail, std::memory_order_release);
+    }
+
+    const int tid;
+    std::atomic<const char*> name;
+    std::atomic<Uint64> dropped{ 0 };
+
+private:
+    std::vector<TraceEvent> events;
+    std::atomic<size_t> head_{ 0 };
+    std::atomic<size_t> tail_{ 0 };
+};
+
+// Process-wide capture. While disabled a zone costs one relaxed load; while
+// enabled, two counter reads and a ring push. The main thread drains the
+// rings with Collect() and writes Chrome trace JSON, which chrome://tracing
+// and Perfetto both open.
+class Tracer {
+public:
+    bool Enabled() const {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    void Start();
+    void Stop();
+
+    // Labels the calling thread in the trace. name must outlive the tracer.
+    void SetThreadName(const char* name);
+
+    void Record(const char* name, Uint64 start, Uint64 end);
+
+    // Moves buffered events of every thread into the capture.
+    void Collect();
+
+    bool Write(const std::string& path);
+
+private:
+    TraceRing* ThreadRing();
+
+    std::atomic<bool> enabled{ false };
+    Uint64 origin = 0;
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<TraceRing>> rings;
+    std::vector<std::pair<int, TraceEvent>> collected;
+    Uint64 overflow = 0;
+};
+
+extern Tracer tracer;
+
+// Records the time between construction and End() or destruction.
+class TraceZone {
+public:
+    explicit TraceZone(const char* name) : name(name), start(tracer.Enabled() ? SDL_GetPerformanceCounter() : 0) {
+    }
+
+    ~TraceZone() {
+        End();
+    }
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+    void End() {
+        if (start != 0) {
+            tracer.Record(name, start, SDL_GetPerformanceCounter());
+            start = 0;
+        }
+    }
+
+private:
+    const char* name;
+    Uint64 start;
+};
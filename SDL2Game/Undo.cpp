@@ -0,0 +1,62 @@
+﻿#include "Undo.h"
+
+using namespace std;
+
+// [u32 size][payload] per entry, payloads as in the journal.
+string UndoHistory::Encode(const vector<JournalEntry>& entries) {
+    JournalWriter out;
+    for (const JournalEntry& entry : entries) {
+        JournalWriter payload;
+        EncodeJournalPayload(payload, entry);
+        out.Str(payload.bytes);
+    }
+    return move(out.bytes);
+}
+
+void UndoHistory::Decode(const string& bytes, vector<JournalEntry>& out) {
+    out.clear();
+    JournalReader in(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size());
+    while (in.ok) {
+        string payload = in.Str();
+        if (!in.ok) break;
+        JournalEntry entry;
+        if (DecodeJournalEntry(reinterpret_cast<const unsigned char*>(payload.data()), payload.size(), entry)) {
+            out.push_back(entry);
+        }
+    }
+}
+
+void UndoHistory::Record(const vector<JournalEntry>& undo, const vector<JournalEntry>& redo) {
+    for (const Step& step : undone) bytes -= step.Bytes();
+    undone.clear();
+    if (undo.empty()) return;
+
+    done.push_back(Step{ Encode(undo), Encode(redo) });
+    bytes += done.back().Bytes();
+    while (done.size() > 1 && (done.size() > maxSteps || bytes > maxBytes)) {
+        bytes -= done.front().Bytes();
+        done.pop_front();
+    }
+}
+
+bool UndoHistory::Undo(vector<JournalEntry>& out) {
+    if (done.empty()) return false;
+    Decode(done.back().undo, out);
+    undone.push_back(move(done.back()));
+    done.pop_back();
+    return true;
+}
+
+bool UndoHistory::Redo(vector<JournalEntry>& out) {
+    if (undone.empty()) return false;
+    Decode(undone.back().redo, out);
+    done.push_back(move(undone.back()));
+    undone.pop_back();
+    return true;
+}
+
+void UndoHistory::Clear() {
+    done.clear();
+    undone.clear();
+    bytes = 0;
+}
@@ -0,0 +1,50 @@
+﻿#pragma once
+
+#include <SDL.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "Journal.h"
+
+const size_t undoMaxSteps = 1000;
+const size_t undoMaxBytes = 4 * 1024 * 1024;
+
+// Bounded undo/redo of inventory commits. A step keeps the journal payloads
+// of the entries that revert it and of the entries that made it, so history
+// costs about the size of the touched toys, never a copy of the inventory.
+// The oldest steps are dropped past either limit.
+class UndoHistory {
+public:
+    UndoHistory(size_t maxSteps = undoMaxSteps, size_t maxBytes = undoMaxBytes)
+        : maxSteps(maxSteps), maxBytes(maxBytes) {
+    }
+
+    // One user action; clears the redo stack.
+    void Record(const std::vector<JournalEntry>& undo, const std::vector<JournalEntry>& redo);
+
+    // Move the newest step across and return the entries to apply, in order.
+    bool Undo(std::vector<JournalEntry>& out);
+    bool Redo(std::vector<JournalEntry>& out);
+
+    void Clear();
+
+private:
+    struct Step {
+        std::string undo;
+        std::string redo;
+
+        size_t Bytes() const {
+            return undo.size() + redo.size();
+        }
+    };
+
+    static std::string Encode(const std::vector<JournalEntry>& entries);
+    static void Decode(const std::string& bytes, std::vector<JournalEntry>& out);
+
+    size_t maxSteps;
+    size_t maxBytes;
+    std::deque<Step> done;
+    std::vector<Step> undone;
+    size_t bytes = 0;
+};
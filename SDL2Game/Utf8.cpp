@@ -0,0 +1,41 @@
+﻿#include "Utf8.h"
+
+using namespace std;
+
+Uint32 DecodeUTF8(const char*& p, const char* end) {
+    unsigned char c = static_cast<unsigned char>(*p++);
+    if (c < 0x80) return c;
+    int extra = (c >= 0xF0) ? 3 : (c >= 0xE0) ? 2 : (c >= 0xC0) ? 1 : -1;
+    if (extra < 0 || end - p < extra) return 0xFFFD;
+    Uint32 cp = c & (0x3F >> extra);
+    for (int i = 0; i < extra; ++i) {
+        unsigned char cc = static_cast<unsigned char>(*p);
+        if ((cc & 0xC0) != 0x80) return 0xFFFD;
+        cp = (cp << 6) | (cc & 0x3F);
+        ++p;
+    }
+    return cp;
+}
+
+size_t EncodeUTF8(Uint32 cp, char* out) {
+    if (cp < 0x80) {
+        out[0] = char(cp);
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = char(0xC0 | (cp >> 6));
+        out[1] = char(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = char(0xE0 | (cp >> 12));
+        out[1] = char(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = char(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = char(0xF0 | (cp >> 18));
+    out[1] = char(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = char(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = char(0x80 | (cp & 0x3F));
+    return 4;
+}
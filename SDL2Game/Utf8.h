@@ -0,0 +1,7 @@
+﻿#pragma once
+
+#include <SDL.h>
+
+Uint32 DecodeUTF8(const char*& p, const char* end);
+
+size_t EncodeUTF8(Uint32 cp, char* out);
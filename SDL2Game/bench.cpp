@@ -0,0 +1,10 @@
+﻿#include "App.h"
+
+// The app in headless mode: --bench-toys and --bench-frames choose the
+// workload, and the frame-time report is printed on exit.
+int main(int argc, char* argv[]) {
+    AppOptions options = ParseOptions(argc, argv);
+    options.headless = true;
+    options.continuousRendering = true;
+    return RunApp(options);
+}
@@ -0,0 +1,52 @@
+﻿#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Minimal self-registering test harness: TEST defines a case, CHECK records
+// a failure and keeps going so one run reports every broken expectation.
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+std::vector<TestCase>& TestCases();
+void ReportFailure(const char* file, int line, const char* expression);
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, void (*run)()) {
+        TestCases().push_back({ name, run });
+    }
+};
+
+#define TEST(name) \
+    static void name(); \
+    static TestRegistrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(expression) \
+    do { \
+        if (!(expression)) ReportFailure(__FILE__, __LINE__, #expression); \
+    } while (0)
+
+// Scratch file in the working directory, removed when the test ends.
+class TempFile {
+public:
+    explicit TempFile(const std::string& name) : path("toystore_tests_" + name) {
+        std::remove(path.c_str());
+    }
+
+    ~TempFile() {
+        std::remove(path.c_str());
+    }
+
+    void Write(const std::string& bytes) const {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file) return;
+        fwrite(bytes.data(), 1, bytes.size(), file);
+        fclose(file);
+    }
+
+    const std::string path;
+};
@@ -0,0 +1,77 @@
+﻿#include "Check.h"
+
+#include "Importer.h"
+
+using namespace std;
+
+static vector<Toy> Import(const string& name, const string& contents, ImportStats& stats) {
+    TempFile file(name);
+    file.Write(contents);
+    CatalogImporter importer;
+    vector<Toy> toys;
+    if (!importer.Start(file.path)) return toys;
+    vector<Toy> batch;
+    while (importer.Active()) {
+        if (importer.PollBatch(batch)) toys.insert(toys.end(), batch.begin(), batch.end());
+        else SDL_Delay(1);
+    }
+    stats = importer.Stats();
+    return toys;
+}
+
+TEST(ImportCsvEdgeCases) {
+    // The header reorders the columns and may leave the description out.
+    string csv =
+        "name,quantity,price,description\r\n"
+        "Robot,3,1.50,\"tin, wind-up\"\r\n"
+        "\"Say \"\"hi\"\" doll\",1,$2,\"two\nlines\"\n"
+        "  Kite  ,2,  4\n"
+        "\n"
+        "Negative,1,-5,\n"
+        "Bad count,x,1,\n"
+        ",1,1,no name\n"
+        "Bad price,1,abc,\n"
+        "Round,5,0.999";
+    ImportStats stats;
+    vector<Toy> toys = Import("import.csv", csv, stats);
+    CHECK(stats.done);
+    CHECK(stats.accepted == 4);
+    CHECK(stats.rejected == 4);
+    CHECK(toys.size() == 4);
+    if (toys.size() != 4) return;
+
+    CHECK(toys[0].name == "Robot" && toys[0].description == "tin, wind-up");
+    CHECK(toys[0].price.cents == 150 && toys[0].quantity == 3);
+    CHECK(toys[1].name == "Say \"hi\" doll" && toys[1].description == "two\nlines");
+    CHECK(toys[1].price.cents == 200);
+    CHECK(toys[2].name == "Kite" && toys[2].description.empty() && toys[2].price.cents == 400);
+    CHECK(toys[3].name == "Round" && toys[3].price.cents == 100);
+}
+
+TEST(ImportJsonLinesEdgeCases) {
+    string jsonl =
+        "{\"name\": \"Caf\\u00e9 set\", \"price\": 12.5, \"quantity\": 2, \"extra\": true}\n"
+        "{\"quantity\": 1, \"description\": \"tab\\tand \\\"quote\\\"\", \"name\": \"Ball\", \"price\": \"3\"}\n"
+        "{\"name\": \"Emoji \\ud83d\\ude00\", \"price\": 1, \"quantity\": 0}\n"
+        "{\"name\": \"No price\", \"quantity\": 1}\n"
+        "{\"name\": \"Unterminated, \"price\": 1, \"quantity\": 1\n"
+        "not json\n"
+        "{\"name\": \"Last\", \"price\": 2, \"quantity\": 1}";
+    ImportStats stats;
+    vector<Toy> toys = Import("import.jsonl", jsonl, stats);
+    CHECK(stats.accepted == 4);
+    CHECK(stats.rejected == 3);
+    CHECK(toys.size() == 4);
+    if (toys.size() != 4) return;
+
+    CHECK(toys[0].name == "Caf\xC3\xA9 set" && toys[0].price.cents == 1250 && toys[0].quantity == 2);
+    CHECK(toys[1].name == "Ball" && toys[1].description == "tab\tand \"quote\"" && toys[1].price.cents == 300);
+    CHECK(toys[2].name == "Emoji \xF0\x9F\x98\x80" && toys[2].quantity == 0);
+    CHECK(toys[3].name == "Last");
+}
+
+TEST(ImportMissingFile) {
+    CatalogImporter importer;
+    CHECK(!importer.Start("toystore_tests_missing.csv"));
+    CHECK(!importer.Active());
+}
@@ -0,0 +1,244 @@
+﻿#include "Check.h"
+
+#include <random>
+
+#include "Inventory.h"
+
+using namespace std;
+
+TEST(MoneyParse) {
+    Money money;
+    CHECK(Money::Parse("12", money) && money.cents == 1200);
+    CHECK(Money::Parse("12.5", money) && money.cents == 1250);
+    CHECK(Money::Parse(" $12.34 ", money) && money.cents == 1234);
+    CHECK(Money::Parse("-3", money) && money.cents == -300);
+    CHECK(Money::Parse("0,99", money) && money.cents == 99);
+    CHECK(Money::Parse("1.005", money) && money.cents == 101);
+    CHECK(Money::Parse("1.0049", money) && money.cents == 100);
+    CHECK(Money::Parse(".5", money) && money.cents == 50);
+    CHECK(!Money::Parse("", money));
+    CHECK(!Money::Parse("$", money));
+    CHECK(!Money::Parse("1.2.3", money));
+    CHECK(!Money::Parse("12abc", money));
+    CHECK(!Money::Parse("1234567890123456", money));
+    CHECK(Money::FromCents(-5).ToString() == "-0.05");
+    CHECK(Money::FromCents(123456).ToString() == "1234.56");
+}
+
+TEST(CowVectorCopiesAreSnapshots) {
+    CowVector<int> values;
+    vector<int> expected;
+    for (int i = 0; i < int(cowChunkSize) * 3 + 17; ++i) {
+        values.push_back(i);
+        expected.push_back(i);
+    }
+    CowVector<int> snapshot = values;
+    vector<int> frozen = expected;
+
+    mt19937 rng(7);
+    for (int step = 0; step < 20000; ++step) {
+        size_t index = rng() % expected.size();
+        switch (rng() % 3) {
+        case 0:
+            values.Mutable(index) = int(rng());
+            expected[index] = values[index];
+            break;
+        case 1:
+            values.push_back(step);
+            expected.push_back(step);
+            break;
+        default:
+            values.pop_back();
+            expected.pop_back();
+            break;
+        }
+    }
+
+    CHECK(values.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) CHECK(values[i] == expected[i]);
+    CHECK(snapshot.size() == frozen.size());
+    for (size_t i = 0; i < frozen.size(); ++i) CHECK(snapshot[i] == frozen[i]);
+
+    size_t total = 0;
+    for (size_t c = 0; c < values.ChunkCount(); ++c) {
+        for (size_t i = 0; i < values.ChunkSize(c); ++i) CHECK(values.ChunkData(c)[i] == expected[total + i]);
+        total += values.ChunkSize(c);
+    }
+    CHECK(total == expected.size());
+}
+
+TEST(InventoryCopyIsSnapshot) {
+    Inventory inventory;
+    for (ToyId id = 1; id <= 5000; ++id) {
+        inventory.Insert(id, Toy{ "toy " + to_string(id), "", Money::FromCents(id), 1 });
+    }
+    Inventory snapshot = inventory;
+    for (size_t slot = 0; slot < inventory.Size(); slot += 3) {
+        inventory.SetDetails(slot, "edited", "", Money::FromCents(0));
+    }
+    for (ToyId id = 2; id <= 5000; id += 7) inventory.Remove(id);
+
+    CHECK(snapshot.Size() == 5000);
+    for (size_t slot = 0; slot < snapshot.Size(); ++slot) {
+        ToyId id = snapshot.IdAt(slot);
+        CHECK(snapshot.Name(slot).Str() == "toy " + to_string(id));
+        CHECK(snapshot.Price(slot).cents == Sint64(id));
+    }
+}
+
+TEST(LedgerRangeSum) {
+    Ledger ledger;
+    mt19937 rng(11);
+    vector<LedgerRecord> records;
+    for (int i = 0; i < 2000; ++i) {
+        // Spread over several days, negative times included, out of order.
+        Sint64 time = Sint64(rng() % (96 * ledgerBucketSeconds)) - 24 * ledgerBucketSeconds;
+        LedgerRecord record = { time, Sint64(rng() % 10000) - 2000, ToyId(i + 1), 1 };
+        ledger.Record(record);
+        records.push_back(record);
+    }
+    Sint64 total = 0;
+    for (const LedgerRecord& record : records) total += record.amountCents;
+    CHECK(ledger.Total().cents == total);
+    CHECK(ledger.Size() == records.size());
+
+    auto BucketOf = [](Sint64 time) {
+        return time >= 0 ? time / ledgerBucketSeconds : -((-time + ledgerBucketSeconds - 1) / ledgerBucketSeconds);
+        };
+    for (int query = 0; query < 500; ++query) {
+        Sint64 from = Sint64(rng() % (120 * ledgerBucketSeconds)) - 36 * ledgerBucketSeconds;
+        Sint64 to = from + Sint64(rng() % (48 * ledgerBucketSeconds));
+        Sint64 expected = 0;
+        if (to > from) {
+            for (const LedgerRecord& record : records) {
+                Sint64 bucket = BucketOf(record.time);
+                if (bucket >= BucketOf(from) && bucket <= BucketOf(to - 1)) expected += record.amountCents;
+            }
+        }
+        CHECK(ledger.RangeSum(from, to).cents == expected);
+    }
+}
+
+TEST(LedgerWindowStaysBounded) {
+    // Three years of hourly sales in time order: the window slides, and the
+    // recent range sums and the grand total stay exact.
+    Ledger ledger;
+    const Sint64 start = 1700000000;
+    const Sint64 hours = 3 * 24 * 365;
+    for (Sint64 hour = 0; hour < hours; ++hour) ledger.Record({ start + hour * ledgerBucketSeconds, hour % 7, 1, 1 });
+    Sint64 total = 0;
+    Sint64 lastDay = 0;
+    for (Sint64 hour = 0; hour < hours; ++hour) {
+        total += hour % 7;
+        if (hour >= hours - 24) lastDay += hour % 7;
+    }
+    Sint64 end = start + hours * ledgerBucketSeconds;
+    CHECK(ledger.Total().cents == total);
+    CHECK(ledger.RangeSum(end - 24 * ledgerBucketSeconds, end).cents == lastDay);
+    CHECK(ledger.RangeSum(numeric_limits<Sint64>::min(), numeric_limits<Sint64>::max()).cents == total);
+
+    // Corrupt far-off times must not size the buckets by their distance.
+    Ledger corrupt;
+    corrupt.Record({ 0, 1, 1, 1 });
+    corrupt.Record({ numeric_limits<Sint64>::max(), 2, 1, 1 });
+    corrupt.Record({ numeric_limits<Sint64>::min(), 4, 1, 1 });
+    corrupt.Record({ start, 8, 1, 1 });
+    CHECK(corrupt.Total().cents == 15);
+    CHECK(corrupt.RangeSum(numeric_limits<Sint64>::min(), numeric_limits<Sint64>::max()).cents == 15);
+}
+
+TEST(InventoryCompactStrings) {
+    Inventory inventory;
+    for (ToyId id = 1; id <= 500; ++id) {
+        inventory.Insert(id, Toy{ "toy " + to_string(id), string(300, 'd'), Money::FromCents(100), 1 });
+    }
+    Inventory snapshot = inventory;
+    for (int round = 0; round < 20; ++round) {
+        for (size_t slot = 0; slot < inventory.Size(); ++slot) {
+            inventory.SetDetails(slot, "edit " + to_string(round), string(300, char('a' + round)), Money::FromCents(1));
+        }
+    }
+    inventory.Remove(7);
+    CHECK(inventory.StringsNeedCompaction());
+
+    inventory.CompactStrings();
+    CHECK(inventory.DeadStringBytes() == 0);
+    CHECK(!inventory.StringsNeedCompaction());
+    CHECK(inventory.Size() == 499);
+    for (size_t slot = 0; slot < inventory.Size(); ++slot) {
+        CHECK(inventory.Name(slot).Str() == "edit 19");
+        CHECK(inventory.Description(slot).Str() == string(300, 'a' + 19));
+    }
+    // Copies taken before the compaction still read the old arena.
+    for (size_t slot = 0; slot < snapshot.Size(); ++slot) {
+        CHECK(snapshot.Name(slot).Str() == "toy " + to_string(snapshot.IdAt(slot)));
+    }
+}
+
+TEST(CatalogRoundTrip) {
+    Inventory inventory;
+    Ledger ledger;
+    inventory.Insert(3, Toy{ "Robot", "tin", Money::FromCents(1999), 4 });
+    inventory.Insert(9, Toy{ "Kite", "", Money::FromCents(250), 0 });
+    ledger.Record({ 7200, 1999, 3, 1 });
+    TempFile file("roundtrip.cat");
+    CHECK(WriteCatalog(file.path, inventory, ledger, 42));
+
+    auto catalog = make_shared<Catalog>();
+    CHECK(catalog->Open(file.path));
+    CHECK(catalog->JournalSeq() == 42);
+    Inventory loaded;
+    Ledger loadedLedger;
+    loaded.Load(catalog);
+    loadedLedger.Load(*catalog);
+    CHECK(loaded.Size() == 2 && loaded.NextId() == 10);
+    int slot = loaded.SlotOf(3);
+    CHECK(slot >= 0 && loaded.Get(slot).name == "Robot" && loaded.Price(slot).cents == 1999);
+    CHECK(loadedLedger.Size() == 1 && loadedLedger.Total().cents == 1999);
+    CHECK(loadedLedger.RangeSum(7200, 7201).cents == 1999);
+    catalog->Close();
+
+    // Any other version is refused rather than guessed at.
+    MappedFile mapped;
+    CHECK(mapped.Open(file.path));
+    string bytes(reinterpret_cast<const char*>(mapped.Data()), mapped.Size());
+    mapped.Close();
+    CatalogHeader header;
+    memcpy(&header, bytes.data(), sizeof(header));
+    header.version = catalogVersion - 1;
+    memcpy(&bytes[0], &header, sizeof(header));
+    file.Write(bytes);
+    Catalog old;
+    CHECK(!old.Open(file.path));
+    file.Write(bytes.substr(0, sizeof(header) - 1));
+    CHECK(!old.Open(file.path));
+}
+
+TEST(CatalogRejectsBadIds) {
+    Inventory inventory;
+    inventory.Insert(3, Toy{ "Robot", "tin", Money::FromCents(1999), 4 });
+    inventory.Insert(9, Toy{ "Kite", "", Money::FromCents(250), 0 });
+    TempFile file("badids.cat");
+    CHECK(WriteCatalog(file.path, inventory, Ledger(), 0));
+    MappedFile mapped;
+    CHECK(mapped.Open(file.path));
+    string bytes(reinterpret_cast<const char*>(mapped.Data()), mapped.Size());
+    mapped.Close();
+    CatalogHeader header;
+    memcpy(&header, bytes.data(), sizeof(header));
+
+    // Patches the second record's id, which the first one keeps at 3.
+    const ToyId bad[] = { invalidToyId, 0xFFFFFFFF, catalogIdFloor + 1, 3 };
+    for (ToyId id : bad) {
+        string corrupt = bytes;
+        memcpy(&corrupt[size_t(header.recordsOffset + sizeof(CatalogRecord))], &id, sizeof(id));
+        file.Write(corrupt);
+        Catalog catalog;
+        CHECK(!catalog.Open(file.path));
+    }
+    ToyId good = catalogIdFloor;
+    memcpy(&bytes[size_t(header.recordsOffset + sizeof(CatalogRecord))], &good, sizeof(good));
+    file.Write(bytes);
+    Catalog catalog;
+    CHECK(catalog.Open(file.path));
+}
@@ -0,0 +1,300 @@
+﻿#include "Check.h"
+
+#include <algorithm>
+#include <random>
+
+#include "Journal.h"
+#include "Undo.h"
+
+using namespace std;
+
+static JournalEntry SampleEntry(int i) {
+    static const JournalOp ops[] = { JournalOp::Add, JournalOp::Delete, JournalOp::Sell, JournalOp::Edit, JournalOp::Refund,
+        JournalOp::Checkout };
+    JournalEntry entry;
+    entry.op = ops[i % 6];
+    entry.id = ToyId(i + 1);
+    entry.toy = Toy{ "toy" + to_string(i), "desc", Money::FromCents(i * 10), i };
+    entry.amount = Money::FromCents(i * 7);
+    entry.time = i;
+    if (entry.op == JournalOp::Checkout) {
+        entry.lines.push_back({ ToyId(i), 2, Money::FromCents(40) });
+        entry.lines.push_back({ ToyId(i + 2), 1, Money::FromCents(15) });
+    }
+    return entry;
+}
+
+// Sorted, so slot order does not matter.
+static string Dump(const Inventory& inventory, const Ledger& ledger) {
+    vector<string> rows;
+    for (size_t slot = 0; slot < inventory.Size(); ++slot) {
+        Toy toy = inventory.Get(slot);
+        rows.push_back(to_string(inventory.IdAt(slot)) + "|" + toy.name + "|" + toy.description + "|" +
+            to_string(toy.price.cents) + "|" + to_string(toy.quantity));
+    }
+    sort(rows.begin(), rows.end());
+    string out;
+    for (const string& row : rows) out += row + "\n";
+    return out + "total " + to_string(ledger.Total().cents) + " day " + to_string(ledger.RangeSum(0, 86400).cents);
+}
+
+struct Store {
+    Inventory inventory;
+    Ledger ledger;
+    UndoHistory history = UndoHistory(100000, 1 << 30);
+
+    bool Commit(const JournalEntry& entry) {
+        vector<JournalEntry> undo;
+        InvertJournalEntry(inventory, entry, undo);
+        if (!ApplyJournalEntry(inventory, ledger, entry)) return false;
+        history.Record(undo, { entry });
+        return true;
+    }
+
+    void UndoAll() {
+        vector<JournalEntry> entries;
+        while (history.Undo(entries)) {
+            for (const JournalEntry& entry : entries) CHECK(ApplyJournalEntry(inventory, ledger, entry));
+        }
+    }
+
+    void RedoAll() {
+        vector<JournalEntry> entries;
+        while (history.Redo(entries)) {
+            for (const JournalEntry& entry : entries) CHECK(ApplyJournalEntry(inventory, ledger, entry));
+        }
+    }
+};
+
+TEST(UndoSellOfLastUnit) {
+    Store store;
+    store.inventory.Insert(1, Toy{ "Robot", "tin", Money::FromCents(1999), 1 });
+    string before = Dump(store.inventory, store.ledger);
+
+    JournalEntry sell;
+    sell.op = JournalOp::Sell;
+    sell.id = 1;
+    sell.amount = Money::FromCents(1999);
+    sell.time = 3600;
+    CHECK(store.Commit(sell));
+    CHECK(store.inventory.Empty());
+    CHECK(store.ledger.Total().cents == 1999);
+
+    store.UndoAll();
+    CHECK(Dump(store.inventory, store.ledger) == before);
+    store.RedoAll();
+    CHECK(store.inventory.Empty());
+}
+
+TEST(UndoCheckoutOfLastUnits) {
+    Store store;
+    store.inventory.Insert(1, Toy{ "Robot", "", Money::FromCents(500), 2 });
+    store.inventory.Insert(2, Toy{ "Kite", "", Money::FromCents(300), 5 });
+    string before = Dump(store.inventory, store.ledger);
+
+    JournalEntry checkout;
+    checkout.op = JournalOp::Checkout;
+    checkout.time = 7200;
+    checkout.lines.push_back({ 1, 2, Money::FromCents(1000) });
+    checkout.lines.push_back({ 2, 1, Money::FromCents(300) });
+    CHECK(store.Commit(checkout));
+    CHECK(store.inventory.SlotOf(1) < 0);
+    CHECK(store.inventory.Quantity(store.inventory.SlotOf(2)) == 4);
+    string after = Dump(store.inventory, store.ledger);
+
+    // A line that no longer fits rejects the whole checkout.
+    JournalEntry tooMany = checkout;
+    tooMany.lines = { { 2, 9, Money::FromCents(2700) } };
+    CHECK(!store.Commit(tooMany));
+    CHECK(Dump(store.inventory, store.ledger) == after);
+
+    store.UndoAll();
+    CHECK(Dump(store.inventory, store.ledger) == before);
+    store.RedoAll();
+    CHECK(Dump(store.inventory, store.ledger) == after);
+}
+
+TEST(UndoRandomHistoryRoundTrip) {
+    Store store;
+    mt19937 rng(19);
+    for (ToyId id = 1; id <= 20; ++id) {
+        store.inventory.Insert(id, Toy{ "toy" + to_string(id), "d", Money::FromCents(100 + id), int(id % 3) + 1 });
+    }
+    string start = Dump(store.inventory, store.ledger);
+
+    for (int step = 0; step < 3000; ++step) {
+        JournalEntry entry;
+        int op = int(rng() % 5);
+        if (op == 0 || store.inventory.Empty()) {
+            entry.op = JournalOp::Add;
+            entry.id = store.inventory.NextId();
+            entry.toy = Toy{ "new" + to_string(step), "x", Money::FromCents(step), int(rng() % 3) };
+        }
+        else {
+            size_t slot = rng() % store.inventory.Size();
+            entry.id = store.inventory.IdAt(slot);
+            entry.time = Sint64(rng() % 86400);
+            if (op == 1) {
+                entry.op = JournalOp::Delete;
+            }
+            else if (op == 2) {
+                entry.op = JournalOp::Sell;
+                entry.amount = store.inventory.Price(slot);
+            }
+            else if (op == 3) {
+                entry.op = JournalOp::Edit;
+                entry.toy = Toy{ "edit" + to_string(step), "dd", Money::FromCents(step * 3), 0 };
+            }
+            else {
+                entry.op = JournalOp::Checkout;
+                for (int i = 0; i < 4; ++i) {
+                    size_t lineSlot = rng() % store.inventory.Size();
+                    ToyId id = store.inventory.IdAt(lineSlot);
+                    bool used = false;
+                    for (const JournalLine& line : entry.lines) used = used || line.id == id;
+                    int quantity = min(int(rng() % 3) + 1, store.inventory.Quantity(lineSlot));
+                    if (used || quantity <= 0) continue;
+                    entry.lines.push_back({ id, quantity, store.inventory.Price(lineSlot) * quantity });
+                }
+            }
+        }
+        store.Commit(entry);
+    }
+    string end = Dump(store.inventory, store.ledger);
+
+    store.UndoAll();
+    CHECK(Dump(store.inventory, store.ledger) == start);
+    store.RedoAll();
+    CHECK(Dump(store.inventory, store.ledger) == end);
+}
+
+TEST(UndoHistoryDropsOldestSteps) {
+    UndoHistory history(5, 1 << 20);
+    for (int i = 0; i < 10; ++i) {
+        JournalEntry entry;
+        entry.op = JournalOp::Delete;
+        entry.id = ToyId(i + 1);
+        history.Record({ entry }, { entry });
+    }
+    vector<JournalEntry> entries;
+    int steps = 0;
+    while (history.Undo(entries)) {
+        CHECK(entries.size() == 1 && entries[0].id == ToyId(10 - steps));
+        steps++;
+    }
+    CHECK(steps == 5);
+}
+
+TEST(JournalEncodeDecode) {
+    for (int i = 0; i < 12; ++i) {
+        JournalEntry entry = SampleEntry(i);
+        JournalWriter writer;
+        EncodeJournalEntry(writer, Uint64(i + 1), entry);
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(writer.bytes.data());
+        JournalEntry decoded;
+        CHECK(DecodeJournalEntry(bytes + journalRecordHeaderSize, writer.bytes.size() - journalRecordHeaderSize,
+            decoded));
+        CHECK(decoded.op == entry.op);
+        CHECK(decoded.id == entry.id || entry.op == JournalOp::Checkout);
+        CHECK(decoded.lines.size() == entry.lines.size());
+        if (entry.op == JournalOp::Add || entry.op == JournalOp::Edit) {
+            CHECK(decoded.toy.name == entry.toy.name && decoded.toy.description == entry.toy.description);
+            CHECK(decoded.toy.price == entry.toy.price);
+        }
+        if (entry.op == JournalOp::Sell) CHECK(decoded.amount == entry.amount && decoded.time == entry.time);
+        if (entry.op == JournalOp::Refund) {
+            CHECK(decoded.amount == entry.amount && decoded.time == entry.time);
+            CHECK(decoded.toy.quantity == entry.toy.quantity);
+        }
+        for (size_t line = 0; line < min(entry.lines.size(), decoded.lines.size()); ++line) {
+            CHECK(decoded.lines[line].id == entry.lines[line].id);
+            CHECK(decoded.lines[line].quantity == entry.lines[line].quantity);
+            CHECK(decoded.lines[line].amount == entry.lines[line].amount);
+        }
+
+        // Every truncation of the payload fails instead of reading past it.
+        for (size_t size = 0; size + journalRecordHeaderSize < writer.bytes.size(); ++size) {
+            string truncated(writer.bytes, journalRecordHeaderSize, size);
+            CHECK(!DecodeJournalEntry(reinterpret_cast<const unsigned char*>(truncated.data()), size,
+                decoded));
+        }
+    }
+
+    string unknown(1, char(99));
+    JournalEntry decoded;
+    CHECK(!DecodeJournalEntry(reinterpret_cast<const unsigned char*>(unknown.data()), unknown.size(), decoded));
+}
+
+static JournalReplayResult Replay(const string& path, Uint64 afterSeq, vector<JournalEntry>& out) {
+    out.clear();
+    return ReplayJournal(path, afterSeq, [&](const JournalEntry& entry) {
+        out.push_back(entry);
+        });
+}
+
+TEST(JournalReplayStopsAtTornOrCorruptRecord) {
+    JournalWriter writer;
+    vector<size_t> ends;
+    for (int i = 0; i < 5; ++i) {
+        EncodeJournalEntry(writer, Uint64(i + 1), SampleEntry(i));
+        ends.push_back(writer.bytes.size());
+    }
+    TempFile file("replay.journal");
+    vector<JournalEntry> applied;
+
+    file.Write(writer.bytes);
+    JournalReplayResult result = Replay(file.path, 0, applied);
+    CHECK(result.applied == 5 && applied.size() == 5);
+    CHECK(result.lastSeq == 5);
+    CHECK(result.validBytes == writer.bytes.size());
+
+    // Entries up to afterSeq are already in the catalog.
+    result = Replay(file.path, 3, applied);
+    CHECK(result.applied == 2 && result.lastSeq == 5);
+
+    // A write torn anywhere inside the last record drops only that record.
+    for (size_t cut = ends[3] + 1; cut < ends[4]; ++cut) {
+        file.Write(writer.bytes.substr(0, cut));
+        result = Replay(file.path, 0, applied);
+        CHECK(result.applied == 4);
+        CHECK(result.validBytes == ends[3]);
+        CHECK(result.lastSeq == 4);
+    }
+
+    // A flipped byte fails the checksum; replay keeps what came before it.
+    string corrupt = writer.bytes;
+    corrupt[ends[1] + journalRecordHeaderSize + 2] ^= 0x40;
+    file.Write(corrupt);
+    result = Replay(file.path, 0, applied);
+    CHECK(result.applied == 2);
+    CHECK(result.validBytes == ends[1]);
+
+    // A size field pointing past the end is treated as a torn record.
+    corrupt = writer.bytes;
+    corrupt[ends[2] + 3] = char(0x7F);
+    file.Write(corrupt);
+    result = Replay(file.path, 0, applied);
+    CHECK(result.applied == 3);
+    CHECK(result.validBytes == ends[2]);
+
+    file.Write(string());
+    result = Replay(file.path, 7, applied);
+    CHECK(result.applied == 0 && result.validBytes == 0 && result.lastSeq == 7);
+}
+
+TEST(JournalSellOfLastUnitRemovesToy) {
+    Inventory inventory;
+    Ledger ledger;
+    inventory.Insert(1, Toy{ "Robot", "tin", Money::FromCents(1999), 2 });
+    JournalEntry sell;
+    sell.op = JournalOp::Sell;
+    sell.id = 1;
+    sell.amount = Money::FromCents(1999);
+    CHECK(ApplyJournalEntry(inventory, ledger, sell));
+    CHECK(inventory.Quantity(inventory.SlotOf(1)) == 1);
+    CHECK(ApplyJournalEntry(inventory, ledger, sell));
+    CHECK(inventory.SlotOf(1) < 0);
+    CHECK(!ApplyJournalEntry(inventory, ledger, sell));
+    CHECK(ledger.Total().cents == 2 * 1999);
+    CHECK(ledger.Size() == 2);
+}
@@ -0,0 +1,86 @@
+﻿#include "Check.h"
+
+#include <random>
+#include <set>
+
+#include "OrderIndex.h"
+
+using namespace std;
+
+TEST(OrderIndexMatchesSet) {
+    OrderIndex<Sint64, less<Sint64>> index;
+    set<pair<Sint64, ToyId>> expected;
+    vector<Sint64> keyOf(1001, 0);
+    mt19937 rng(3);
+
+    vector<pair<Sint64, ToyId>> initial;
+    for (ToyId id = 1; id <= 300; ++id) {
+        // Few distinct keys, so ties broken by id are exercised.
+        keyOf[id] = Sint64(rng() % 40);
+        initial.emplace_back(keyOf[id], id);
+        expected.insert({ keyOf[id], id });
+    }
+    index.Build(initial);
+
+    for (int step = 0; step < 20000; ++step) {
+        ToyId id = ToyId(1 + rng() % 1000);
+        bool present = expected.count({ keyOf[id], id }) > 0;
+        if (present && rng() % 3 == 0) {
+            index.Erase(id);
+            expected.erase({ keyOf[id], id });
+        }
+        else {
+            if (present) expected.erase({ keyOf[id], id });
+            keyOf[id] = Sint64(rng() % 40);
+            index.Update(id, keyOf[id]);
+            expected.insert({ keyOf[id], id });
+        }
+
+        if (step % 1000 == 0 || step == 19999) {
+            CHECK(index.Size() == expected.size());
+            size_t rank = 0;
+            for (const auto& item : expected) {
+                CHECK(index.At(rank) == item.second);
+                CHECK(index.Rank(item.second) == int(rank));
+                rank++;
+            }
+            CHECK(index.At(expected.size()) == invalidToyId);
+        }
+    }
+    for (ToyId id = 1; id <= 1000; ++id) {
+        CHECK(index.Contains(id) == (expected.count({ keyOf[id], id }) > 0));
+        if (!index.Contains(id)) CHECK(index.Rank(id) == -1);
+    }
+}
+
+TEST(InventoryOrderFollowsUpdates) {
+    Inventory inventory;
+    InventoryOrder order;
+    mt19937 rng(5);
+    for (ToyId id = 1; id <= 200; ++id) {
+        inventory.Insert(id, Toy{ string(1, char('a' + rng() % 26)) + to_string(id), "", Money::FromCents(rng() % 50), int(rng() % 5) });
+    }
+    order.Require(inventory, SortColumn::Name);
+    order.Require(inventory, SortColumn::Price);
+    for (int step = 0; step < 500; ++step) {
+        size_t slot = rng() % inventory.Size();
+        ToyId id = inventory.IdAt(slot);
+        if (step % 7 == 0) {
+            inventory.Remove(id);
+        }
+        else {
+            inventory.SetDetails(slot, string(1, char('A' + rng() % 26)), "", Money::FromCents(rng() % 50));
+        }
+        order.Update(inventory, id);
+    }
+
+    for (size_t rank = 0; rank + 1 < inventory.Size(); ++rank) {
+        int a = inventory.SlotOf(order.At(SortColumn::Name, rank));
+        int b = inventory.SlotOf(order.At(SortColumn::Name, rank + 1));
+        CHECK(a >= 0 && b >= 0 && CompareFolded(inventory.Name(a), inventory.Name(b)) <= 0);
+        int c = inventory.SlotOf(order.At(SortColumn::Price, rank));
+        int d = inventory.SlotOf(order.At(SortColumn::Price, rank + 1));
+        CHECK(c >= 0 && d >= 0 && inventory.Price(c).cents <= inventory.Price(d).cents);
+    }
+    CHECK(order.At(SortColumn::Name, inventory.Size()) == invalidToyId);
+}
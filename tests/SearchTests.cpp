@@ -0,0 +1,104 @@
+﻿#include "Check.h"
+
+#include <algorithm>
+#include <cctype>
+#include <random>
+
+#include "Search.h"
+
+using namespace std;
+
+static string Lower(string text) {
+    for (char& c : text) c = char(tolower(static_cast<unsigned char>(c)));
+    return text;
+}
+
+static string RandomText(mt19937& rng, size_t length) {
+    // A small alphabet so that random queries actually hit.
+    static const char letters[] = "abcABC d";
+    string text;
+    for (size_t i = 0; i < length; ++i) text += letters[rng() % (sizeof(letters) - 1)];
+    return text;
+}
+
+static vector<ToyId> BruteForce(const Inventory& inventory, const string& query) {
+    vector<ToyId> out;
+    string needle = Lower(query);
+    for (size_t slot = 0; slot < inventory.Size(); ++slot) {
+        if (Lower(inventory.Name(slot).Str()).find(needle) != string::npos ||
+            Lower(inventory.Description(slot).Str()).find(needle) != string::npos) {
+            out.push_back(inventory.IdAt(slot));
+        }
+    }
+    sort(out.begin(), out.end());
+    return out;
+}
+
+TEST(SearchMatchesSubstringScan) {
+    Inventory inventory;
+    mt19937 rng(13);
+    for (ToyId id = 1; id <= 400; ++id) {
+        inventory.Insert(id, Toy{ RandomText(rng, 4 + rng() % 12), RandomText(rng, rng() % 40), Money::FromCents(1), 1 });
+    }
+    SearchIndex search;
+    search.Build(inventory);
+
+    for (int step = 0; step < 300; ++step) {
+        // Edits go through Remove/Add with the old strings, as App does.
+        size_t slot = rng() % inventory.Size();
+        ToyId id = inventory.IdAt(slot);
+        TextRef oldName = inventory.Name(slot);
+        TextRef oldDescription = inventory.Description(slot);
+        if (step % 5 == 0) {
+            inventory.Remove(id);
+            search.Remove(id, oldName, oldDescription);
+        }
+        else {
+            inventory.SetDetails(slot, RandomText(rng, 4 + rng() % 12), RandomText(rng, rng() % 40), Money::FromCents(1));
+            search.Remove(id, oldName, oldDescription);
+            search.Add(id, inventory.Name(slot), inventory.Description(slot));
+        }
+
+        string query = RandomText(rng, 3 + rng() % 3);
+        vector<ToyId> found;
+        search.Query(query, inventory, found);
+        vector<ToyId> unique = found;
+        sort(unique.begin(), unique.end());
+        CHECK(adjacent_find(unique.begin(), unique.end()) == unique.end());
+        CHECK(unique == BruteForce(inventory, query));
+
+        // Extending the query refines the previous results.
+        string longer = query + RandomText(rng, 1);
+        search.Query(longer, inventory, found);
+        sort(found.begin(), found.end());
+        CHECK(found == BruteForce(inventory, longer));
+    }
+}
+
+TEST(SearchBuildsOnFirstQuery) {
+    Inventory inventory;
+    inventory.Insert(1, Toy{ "Robot", "", Money::FromCents(1), 1 });
+    SearchIndex search;
+    // Changes before the first query are picked up by the build itself.
+    inventory.Insert(2, Toy{ "Robin", "", Money::FromCents(1), 1 });
+    search.Add(2, inventory.Name(inventory.SlotOf(2)), inventory.Description(inventory.SlotOf(2)));
+    vector<ToyId> found;
+    search.Query("rob", inventory, found);
+    CHECK(found == vector<ToyId>({ 1, 2 }));
+    inventory.Insert(3, Toy{ "Robe", "", Money::FromCents(1), 1 });
+    search.Add(3, inventory.Name(inventory.SlotOf(3)), inventory.Description(inventory.SlotOf(3)));
+    search.Query("rob", inventory, found);
+    CHECK(found == vector<ToyId>({ 3, 1, 2 }));
+}
+
+TEST(SearchFoldsCyrillic) {
+    Inventory inventory;
+    inventory.Insert(1, Toy{ "\xD0\x9C\xD0\xB5\xD0\xB4\xD0\xB2\xD0\xB5\xD0\xB4\xD1\x8C", "", Money::FromCents(1), 1 });
+    inventory.Insert(2, Toy{ "Bear", "plush \xD0\xBC\xD0\xB5\xD0\xB4", Money::FromCents(1), 1 });
+    SearchIndex search;
+    search.Build(inventory);
+    vector<ToyId> found;
+    search.Query("\xD0\xBC\xD0\x95\xD0\x94", inventory, found);
+    // Name matches rank before description matches.
+    CHECK(found == vector<ToyId>({ 1, 2 }));
+}
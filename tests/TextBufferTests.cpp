@@ -0,0 +1,107 @@
+﻿#include "Check.h"
+
+#include <random>
+
+#include "TextBuffer.h"
+
+using namespace std;
+
+TEST(TextBufferMatchesString) {
+    mt19937 rng(17);
+    // Rounds stay below the undo limit so each one can be walked back fully.
+    for (int round = 0; round < 40; ++round) {
+        TextBuffer buffer;
+        string start = "hello " + to_string(round);
+        string expected = start;
+        buffer.Assign(expected);
+        vector<string> history = { expected };
+
+        for (int step = 0; step < 150; ++step) {
+            size_t cursor = rng() % (expected.size() + 1);
+            buffer.MoveTo(cursor, false);
+            switch (rng() % 4) {
+            case 0: {
+                string text(1 + rng() % 3, char('a' + rng() % 26));
+                buffer.Insert(text.data(), text.size());
+                expected.insert(cursor, text);
+                break;
+            }
+            case 1:
+                buffer.Backspace();
+                if (cursor > 0) expected.erase(cursor - 1, 1);
+                break;
+            case 2:
+                buffer.DeleteForward();
+                if (cursor < expected.size()) expected.erase(cursor, 1);
+                break;
+            default: {
+                size_t end = rng() % (expected.size() + 1);
+                buffer.MoveTo(end, true);
+                size_t from = min(cursor, end);
+                size_t to = max(cursor, end);
+                CHECK(buffer.Selected() == expected.substr(from, to - from));
+                buffer.Insert("#", 1);
+                expected.replace(from, to - from, "#");
+                break;
+            }
+            }
+            CHECK(buffer.Text() == expected);
+            CHECK(buffer.Size() == expected.size());
+            if (history.back() != expected) history.push_back(expected);
+        }
+
+        // Undo may coalesce steps, but every state it passes through is one
+        // the buffer actually had, in reverse order.
+        size_t position = history.size() - 1;
+        while (buffer.Undo()) {
+            while (position > 0 && history[position] != buffer.Text()) position--;
+            CHECK(history[position] == buffer.Text());
+        }
+        CHECK(buffer.Text() == start);
+        while (buffer.Redo()) {
+        }
+        CHECK(buffer.Text() == expected);
+    }
+}
+
+TEST(TextBufferUndoGroupsTyping) {
+    TextBuffer buffer;
+    buffer.Assign("abc");
+    const char* typed = "hello world";
+    for (const char* p = typed; *p; ++p) buffer.Insert(p, 1);
+    CHECK(buffer.Text() == "abchello world");
+    buffer.Undo();
+    CHECK(buffer.Text() == "abchello");
+    buffer.Undo();
+    CHECK(buffer.Text() == "abc");
+    buffer.Redo();
+    buffer.Redo();
+    CHECK(buffer.Text() == "abchello world");
+
+    buffer.MoveTo(0, false);
+    buffer.MoveTo(3, true);
+    buffer.Insert("X", 1);
+    CHECK(buffer.Text() == "Xhello world");
+    buffer.Undo();
+    CHECK(buffer.Text() == "abchello world");
+    CHECK(buffer.HasSelection());
+}
+
+TEST(TextBufferStepsOverCodepoints) {
+    TextBuffer buffer;
+    buffer.Assign("a\xD0\xB6" "b");
+    buffer.MoveTo(buffer.Size(), false);
+    buffer.MoveLeft(false, false);
+    CHECK(buffer.Cursor() == 3);
+    buffer.Backspace();
+    CHECK(buffer.Text() == "ab");
+    buffer.MoveRight(false, false);
+    buffer.Insert("\xE2\x82\xAC", 3);
+    CHECK(buffer.Text() == "ab\xE2\x82\xAC");
+    buffer.MoveLeft(true, false);
+    CHECK(buffer.Selected() == "\xE2\x82\xAC");
+    buffer.Undo();
+    CHECK(buffer.Text() == "ab");
+    buffer.Undo();
+    CHECK(buffer.Text() == "a\xD0\xB6" "b");
+}
@@ -0,0 +1,32 @@
+﻿#include "Check.h"
+
+#include <cstring>
+
+using namespace std;
+
+static int failures = 0;
+
+vector<TestCase>& TestCases() {
+    static vector<TestCase> cases;
+    return cases;
+}
+
+void ReportFailure(const char* file, int line, const char* expression) {
+    fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expression);
+    failures++;
+}
+
+int main(int argc, char* argv[]) {
+    // An argument runs only the cases whose name contains it.
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    int ran = 0;
+    for (const TestCase& test : TestCases()) {
+        if (filter && !strstr(test.name, filter)) continue;
+        int before = failures;
+        test.run();
+        printf("%s %s\n", failures == before ? "ok  " : "FAIL", test.name);
+        ran++;
+    }
+    printf("%d tests, %d failed checks\n", ran, failures);
+    return failures == 0 && ran > 0 ? 0 : 1;
+}